@@ -38,6 +38,9 @@
  * The LED flash tasks provide instant visual feedback.  They show that the scheduler 
  * is still operational.
  *
+ * When USE_TIMERS is 1 an auto-reload software timer is used for each LED in 
+ * place of a task, so the eight stacks and TCBs are not needed.
+ *
  * The PC port uses the standard parallel port for outputs, the Flashlite 186 port 
  * uses IO port F.
  *
@@ -56,6 +59,12 @@ Changes from V2.1.1
 
 	+ The stack size now uses portMINIMAL_STACK_SIZE.
 	+ String constants made file scope to decrease stack depth on 8051 port.
+
+Changes from V2.4.1
+
+	+ The flash tasks use cTaskDelayUntil() so the flash rate does not drift.
+	+ Software timers are used in place of the flash tasks when USE_TIMERS is
+	  1.
 */
 
 #include <stdlib.h>
@@ -65,6 +74,10 @@ Changes from V2.1.1
 #include "portable.h"
 #include "task.h"
 
+#if USE_TIMERS == 1
+	#include "timers.h"
+#endif
+
 /* Demo program include files. */
 #include "partest.h"
 #include "flash.h"
@@ -79,15 +92,63 @@ typedef struct LED_PARAMETERS
 	portTickType xFlashRate;	/*< The rate at which the LED should flash. */
 } xLEDParameters;
 
-/* The task that is created eight times - each time with a different xLEDParaemtes 
-structure passed in as the parameter. */
-static void vLEDFlashTask( void *pvParameters );
+#if USE_TIMERS == 1
+
+	/* The callback of the timer created for each LED.  The timer ID is the
+	LED number. */
+	static void vLEDFlashTimerCallback( xTimerHandle xTimer );
+
+#else
+
+	/* The task that is created eight times - each time with a different xLEDParaemtes 
+	structure passed in as the parameter. */
+	static void vLEDFlashTask( void *pvParameters );
+
+#endif
 
 /* String to print if USE_STDIO is defined. */
 const portCHAR * const pcTaskStartMsg = "LED flash task started.\r\n";
 
 /*-----------------------------------------------------------*/
 
+#if USE_TIMERS == 1
+
+void vStartLEDFlashTasks( unsigned portCHAR ucPriority )
+{
+portSHORT sLEDTask;
+xTimerHandle xTimer;
+const portSHORT sNumOfLEDs = 8, sFlashRate = 125;
+
+	/* The timers run in the timer task so the priority is not used. */
+	( void ) ucPriority;
+
+	/* Create the eight timers.  Each toggles its LED every half flash 
+	period. */
+	for( sLEDTask = 0; sLEDTask < sNumOfLEDs; ++sLEDTask )
+	{
+		xTimer = xTimerCreate( ( ( portTickType ) ( sFlashRate + ( sFlashRate * sLEDTask ) ) / portTICKS_PER_MS ) / ( portTickType ) 2, pdTRUE, ( void * ) sLEDTask, vLEDFlashTimerCallback );
+		if( xTimer != NULL )
+		{
+			/* The scheduler has not been started so do not block.  If the
+			command cannot be queued the LED is left on, rather than 
+			flashing, to show the error. */
+			if( cTimerStart( xTimer, ( portTickType ) 0 ) != pdPASS )
+			{
+				vParTestSetLED( ( unsigned portCHAR ) sLEDTask, pdTRUE );
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void vLEDFlashTimerCallback( xTimerHandle xTimer )
+{
+	vParTestToggleLED( ( unsigned portCHAR ) pvTimerGetTimerID( xTimer ) );
+}
+/*-----------------------------------------------------------*/
+
+#else
+
 void vStartLEDFlashTasks( unsigned portCHAR ucPriority )
 {
 portSHORT sLEDTask;
@@ -113,21 +174,28 @@ const portSHORT sNumOfLEDs = 8, sFlashRate = 125;
 static void vLEDFlashTask( void *pvParameters )
 {
 xLEDParameters *pxParameters;
+portTickType xLastFlashTime;
 
 	/* Queue a message for printing to say the task has started. */
 	vPrintDisplayMessage( &pcTaskStartMsg );
 
 	pxParameters = ( xLEDParameters * ) pvParameters;
 
+	/* We need to initialise xLastFlashTime prior to the first call to 
+	cTaskDelayUntil(). */
+	xLastFlashTime = xTaskGetTickCount();
+
 	for(;;)
 	{
 		/* Delay for half the flash period then turn the LED on. */
-		vTaskDelay( pxParameters->xFlashRate / ( portTickType ) 2 );
+		cTaskDelayUntil( &xLastFlashTime, pxParameters->xFlashRate / ( portTickType ) 2 );
 		vParTestToggleLED( pxParameters->ucLED );
 
 		/* Delay for half the flash period then turn the LED off. */
-		vTaskDelay( pxParameters->xFlashRate / ( portTickType ) 2 );
+		cTaskDelayUntil( &xLastFlashTime, pxParameters->xFlashRate / ( portTickType ) 2 );
 		vParTestToggleLED( pxParameters->ucLED );
 	}
 }
 
+#endif
+
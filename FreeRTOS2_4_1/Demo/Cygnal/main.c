@@ -343,9 +343,14 @@ static void prvToggleOnBoardLED( void )
 static void vErrorChecks( void *pvParameters )
 {
 portSHORT sErrorHasOccurred = pdFALSE;
+portTickType xLastWakeTime;
 	
 	/* Just to prevent compiler warnings. */
 	( void ) pvParameters;
+
+	/* Initialise xLastWakeTime before it is first used.  After this point
+	it is managed automatically by cTaskDelayUntil(). */
+	xLastWakeTime = xTaskGetTickCount();
 	
 	/* Cycle for ever, delaying then checking all the other tasks are still
 	operating without error.   The delay period depends on whether an error
@@ -356,14 +361,14 @@ portSHORT sErrorHasOccurred = pdFALSE;
 		{		
 			/* No errors have been detected so delay for a longer period.  The
 			on board LED will get toggled every mainNO_ERROR_FLASH_PERIOD ms. */
-			vTaskDelay( mainNO_ERROR_FLASH_PERIOD );
+			cTaskDelayUntil( &xLastWakeTime, mainNO_ERROR_FLASH_PERIOD );
 		}
 		else
 		{
 			/* We have at some time recognised an error in one of the demo
 			application tasks, delay for a shorter period.  The on board LED
 			will get toggled every mainERROR_FLASH_PERIOD ms. */
-			vTaskDelay( mainERROR_FLASH_PERIOD );
+			cTaskDelayUntil( &xLastWakeTime, mainERROR_FLASH_PERIOD );
 		}
 
 		
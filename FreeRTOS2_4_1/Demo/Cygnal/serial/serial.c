@@ -109,47 +109,41 @@ void vSerialISR( void ) interrupt 4
 {
 portCHAR cChar, cTaskWokenByRx = pdFALSE, cTaskWokenByTx = pdFALSE;
 
-	/* 8051 port interrupt routines MUST be placed within a critical section
-	if taskYIELD() is used within the ISR! */
+	/* The ISR must not call portYIELD() directly.  A context switch is instead
+	requested with portYIELD_FROM_ISR(), and performed once this ISR has 
+	exited. */
 
-	portENTER_CRITICAL();
+	if( RI ) 
 	{
-		if( RI ) 
-		{
-			/* Get the character and post it on the queue of Rxed characters.
-			If the post causes a task to wake force a context switch as the woken task
-			may have a higher priority than the task we have interrupted. */
-			cChar = SBUF;
-			RI = 0;
+		/* Get the character and post it on the queue of Rxed characters.
+		If the post causes a task to wake force a context switch as the woken task
+		may have a higher priority than the task we have interrupted. */
+		cChar = SBUF;
+		RI = 0;
 
-			if( cQueueSendFromISR( xRxedChars, &cChar, pdFALSE ) )
-			{
-				cTaskWokenByRx = ( portCHAR ) pdTRUE;
-			}
+		if( cQueueSendFromISR( xRxedChars, &cChar, pdFALSE ) )
+		{
+			cTaskWokenByRx = ( portCHAR ) pdTRUE;
 		}
+	}
 
-		if( TI ) 
+	if( TI ) 
+	{
+		if( cQueueReceiveFromISR( xCharsForTx, &cChar, &cTaskWokenByTx ) == ( portCHAR ) pdTRUE )
 		{
-			if( cQueueReceiveFromISR( xCharsForTx, &cChar, &cTaskWokenByTx ) == ( portCHAR ) pdTRUE )
-			{
-				/* Send the next character queued for Tx. */
-				SBUF = cChar;
-			}
-			else
-			{
-				/* Queue empty, nothing to send. */
-				ucTxEmpty = pdTRUE;
-			}
-
-			TI = 0;
+			/* Send the next character queued for Tx. */
+			SBUF = cChar;
 		}
-	
-		if( cTaskWokenByRx || cTaskWokenByTx )
+		else
 		{
-			portYIELD();
+			/* Queue empty, nothing to send. */
+			ucTxEmpty = pdTRUE;
 		}
+
+		TI = 0;
 	}
-	portEXIT_CRITICAL();
+
+	portYIELD_FROM_ISR( cTaskWokenByRx || cTaskWokenByTx );
 }
 /*-----------------------------------------------------------*/
 
@@ -0,0 +1,462 @@
+/*
+	FreeRTOS V2.4.1 - Copyright (C) 2003, 2004 Richard Barry.
+
+	This file is part of the FreeRTOS distribution.
+
+	FreeRTOS is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	FreeRTOS is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with FreeRTOS; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+	A special exception to the GPL can be applied should you wish to distribute
+	a combined work that includes FreeRTOS, without being obliged to provide
+	the source code for any proprietary components.  See the licensing section 
+	of http://www.FreeRTOS.org for full details of how and when the exception
+	can be applied.
+
+	***************************************************************************
+	See http://www.FreeRTOS.org for documentation, latest information, license 
+	and contact details.  Please ensure to read the configuration and relevant 
+	port sections of the online documentation.
+	***************************************************************************
+*/
+
+/*
+ * Co-routines.  A co-routine is a function written as a switch statement by
+ * the macros in croutine.h, so it can block by recording where it is to 
+ * resume and returning.  vCoRoutineSchedule() calls the highest priority 
+ * ready co-routine, so all the co-routines run on the stack of whichever task
+ * calls it - normally the idle task.
+ *
+ * The lists here are only accessed by the task that calls vCoRoutineSchedule()
+ * with the exception of the event lists (the queues) and xPendingReadyList,
+ * which can be accessed from ISRs so are only accessed with interrupts 
+ * disabled.
+ */
+
+#include <stdlib.h>
+#include "projdefs.h"
+#include "portable.h"
+#include "task.h"
+#include "list.h"
+#include "errors.h"
+#include "croutine.h"
+
+#if USE_CO_ROUTINES == 1
+
+/* Lists for ready and blocked co-routines. */
+static xList portKERNEL_DATA pxReadyCoRoutineLists[ portMAX_CO_ROUTINE_PRIORITIES ];	/*< Prioritised ready co-routines. */
+static xList portKERNEL_DATA xDelayedCoRoutineList1;									/*< Delayed co-routines. */
+static xList portKERNEL_DATA xDelayedCoRoutineList2;									/*< Delayed co-routines (two lists are used - one for delays that have overflowed the current tick count. */
+static xList portOBJECT_SPACE * portKERNEL_DATA pxDelayedCoRoutineList;				/*< Points to the delayed co-routine list currently being used. */
+static xList portOBJECT_SPACE * portKERNEL_DATA pxOverflowDelayedCoRoutineList;		/*< Points to the delayed co-routine list currently being used to hold co-routines that have overflowed the current tick count. */
+static xList portKERNEL_DATA xPendingReadyCoRoutineList;								/*< Holds co-routines that have been readied by an ISR.  These cannot be placed directly into the ready lists as the ready lists cannot be accessed by ISRs. */
+
+/* Other file private variables. */
+static corCRCB portOBJECT_SPACE * portKERNEL_DATA pxCurrentCoRoutine = NULL;
+static unsigned portCHAR portKERNEL_DATA ucTopCoRoutineReadyPriority = 0;
+
+/* The co-routine tick count.  This is the kernel tick count sampled each time
+vCoRoutineSchedule() is called, so is the time against which co-routine delays
+are measured.  The kernel tick count must not wrap completely between two calls
+to vCoRoutineSchedule() or the wrap will be missed. */
+static portTickType portKERNEL_DATA xCoRoutineTickCount = ( portTickType ) 0;
+
+/* The initial state of the co-routine when it is created. */
+#define corINITIAL_STATE	( ( unsigned portSHORT ) 0 )
+
+/*
+ * Place the co-routine represented by pxCRCB into the appropriate ready queue
+ * for the priority.  It is inserted at the end of the list.
+ *
+ * This macro accesses the co-routine ready lists and therefore must not be
+ * used from within an ISR.
+ */
+#define prvAddCoRoutineToReadyQueue( pxCRCB )																	\
+{																												\
+	if( ( pxCRCB )->ucPriority > ucTopCoRoutineReadyPriority )													\
+	{																											\
+		ucTopCoRoutineReadyPriority = ( pxCRCB )->ucPriority;													\
+	}																											\
+	vListInsertEnd( ( xList portOBJECT_SPACE * ) &( pxReadyCoRoutineLists[ ( pxCRCB )->ucPriority ] ), &( ( pxCRCB )->xGenericListItem ) );	\
+}
+
+/*
+ * Utility to ready all the lists used by the scheduler.  This is called
+ * automatically upon the creation of the first co-routine.
+ */
+static void prvInitialiseCoRoutineLists( void );
+
+/*
+ * Co-routines that are readied by an interrupt cannot be placed directly into
+ * the ready lists (there is no mutual exclusion).  Instead they are placed in
+ * in the pending ready list in order that they can later be moved to the ready
+ * list by the co-routine scheduler.
+ */
+static void prvCheckPendingReadyList( void );
+
+/*
+ * Looks at the list of co-routines that are currently delayed to
+ * see if any require waking.
+ *
+ * Co-routines are stored in the queue in the order of their wake time -
+ * meaning once one co-routine has been found whose timer has not expired
+ * we need not look any further down the list.  Any number of ticks can have
+ * passed since the last call, so the co-routine tick count is moved on to the
+ * kernel tick count in one step, waking everything on the current list first
+ * should the tick count have wrapped.
+ */
+static void prvCheckDelayedList( void );
+
+/*
+ * Move every co-routine whose wake time is no later than xTimeNow from the 
+ * head of the current delayed list to its ready list, or every co-routine in 
+ * the list if cAll is pdTRUE.
+ */
+static void prvWakeDelayedCoRoutines( portTickType xTimeNow, signed portCHAR cAll );
+
+/*-----------------------------------------------------------*/
+
+signed portCHAR cCoRoutineCreate( crCOROUTINE_CODE pxCoRoutineCode, unsigned portCHAR ucPriority, unsigned portCHAR ucIndex )
+{
+signed portCHAR cReturn;
+corCRCB portOBJECT_SPACE *pxCoRoutine;
+
+	/* Allocate the memory that will store the co-routine control block. */
+	pxCoRoutine = ( corCRCB portOBJECT_SPACE * ) pvPortMalloc( sizeof( corCRCB ) );
+	if( pxCoRoutine )
+	{
+		/* If pxCurrentCoRoutine is NULL then this is the first co-routine to
+		be created and the co-routine data structures need initialising. */
+		if( pxCurrentCoRoutine == NULL )
+		{
+			pxCurrentCoRoutine = pxCoRoutine;
+			prvInitialiseCoRoutineLists();
+		}
+
+		/* Check the priority is within limits. */
+		if( ucPriority >= portMAX_CO_ROUTINE_PRIORITIES )
+		{
+			ucPriority = portMAX_CO_ROUTINE_PRIORITIES - ( unsigned portCHAR ) 1;
+		}
+
+		/* Fill out the co-routine control block from the function parameters. */
+		pxCoRoutine->usState = corINITIAL_STATE;
+		pxCoRoutine->ucPriority = ucPriority;
+		pxCoRoutine->ucIndex = ucIndex;
+		pxCoRoutine->pxCoRoutineFunction = pxCoRoutineCode;
+
+		/* Initialise all the other co-routine control block parameters. */
+		vListInitialiseItem( &( pxCoRoutine->xGenericListItem ) );
+		vListInitialiseItem( &( pxCoRoutine->xEventListItem ) );
+
+		/* Set the co-routine control block as a link back from the xListItem.
+		This is so we can get back to the containing CRCB from a generic item
+		in a list. */
+		listSET_LIST_ITEM_OWNER( &( pxCoRoutine->xGenericListItem ), pxCoRoutine );
+		listSET_LIST_ITEM_OWNER( &( pxCoRoutine->xEventListItem ), pxCoRoutine );
+
+		/* Event lists are always in priority order, so the highest priority
+		co-routine waiting on a queue is at the head of its list. */
+		listSET_LIST_ITEM_VALUE( &( pxCoRoutine->xEventListItem ), ( portTickType ) ( portMAX_CO_ROUTINE_PRIORITIES - ucPriority ) );
+
+		/* Now the co-routine has been initialised it can be added to the ready
+		list at the correct priority. */
+		prvAddCoRoutineToReadyQueue( pxCoRoutine );
+
+		cReturn = pdPASS;
+	}
+	else
+	{
+		cReturn = errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+	}
+
+	return cReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vCoRoutineAddToDelayedList( portTickType xTicksToDelay, xList portOBJECT_SPACE *pxEventList )
+{
+portTickType xTimeToWake;
+
+	/* Calculate the time to wake - this may overflow but this is
+	not a problem. */
+	xTimeToWake = xCoRoutineTickCount + xTicksToDelay;
+
+	/* We must remove ourselves from the ready list before adding
+	ourselves to the blocked list as the same list item is used for
+	both lists. */
+	vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxCurrentCoRoutine->xGenericListItem ) );
+
+	/* The list item will be inserted in wake time order. */
+	listSET_LIST_ITEM_VALUE( &( pxCurrentCoRoutine->xGenericListItem ), xTimeToWake );
+
+	if( xTimeToWake < xCoRoutineTickCount )
+	{
+		/* Wake time has overflowed.  Place this item in the
+		overflow list. */
+		vListInsert( ( xList portOBJECT_SPACE * ) pxOverflowDelayedCoRoutineList, ( xListItem portOBJECT_SPACE * ) &( pxCurrentCoRoutine->xGenericListItem ) );
+	}
+	else
+	{
+		/* The wake time has not overflowed, so we can use the
+		current block list. */
+		vListInsert( ( xList portOBJECT_SPACE * ) pxDelayedCoRoutineList, ( xListItem portOBJECT_SPACE * ) &( pxCurrentCoRoutine->xGenericListItem ) );
+	}
+
+	if( pxEventList )
+	{
+		/* Also add the co-routine to an event list.  If this is done then the
+		function must be called with interrupts disabled. */
+		vListInsert( pxEventList, &( pxCurrentCoRoutine->xEventListItem ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckPendingReadyList( void )
+{
+corCRCB portOBJECT_SPACE *pxUnblockedCRCB;
+
+	/* Are there any co-routines waiting to get moved to the ready list?  These
+	are co-routines that have been readied by an ISR.  The ISR cannot access
+	the ready lists itself. */
+	while( !listLIST_IS_EMPTY( &xPendingReadyCoRoutineList ) )
+	{
+		/* The pending ready list can be accessed by an ISR. */
+		portENTER_CRITICAL();
+		{
+			pxUnblockedCRCB = ( corCRCB portOBJECT_SPACE * ) listGET_OWNER_OF_HEAD_ENTRY( ( ( xList portOBJECT_SPACE * ) &xPendingReadyCoRoutineList ) );
+			vListRemove( &( pxUnblockedCRCB->xEventListItem ) );
+		}
+		portEXIT_CRITICAL();
+
+		vListRemove( &( pxUnblockedCRCB->xGenericListItem ) );
+		prvAddCoRoutineToReadyQueue( pxUnblockedCRCB );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvWakeDelayedCoRoutines( portTickType xTimeNow, signed portCHAR cAll )
+{
+corCRCB portOBJECT_SPACE *pxCRCB;
+
+	while( ( pxCRCB = ( corCRCB portOBJECT_SPACE * ) listGET_OWNER_OF_HEAD_ENTRY( pxDelayedCoRoutineList ) ) != NULL )
+	{
+		if( ( cAll == pdFALSE ) && ( xTimeNow < listGET_LIST_ITEM_VALUE( &( pxCRCB->xGenericListItem ) ) ) )
+		{
+			/* Timeout not yet expired. */
+			break;
+		}
+
+		/* The event could have occurred just before this critical section.
+		If this is the case then the generic list item will have been moved
+		to the pending ready list and the following line is still valid.  Also
+		the pvContainer parameter will have been set to NULL so the following
+		lines are also valid. */
+		portENTER_CRITICAL();
+		{
+			vListRemove( &( pxCRCB->xGenericListItem ) );
+
+			/* Is the co-routine waiting on an event also? */
+			if( pxCRCB->xEventListItem.pvContainer )
+			{
+				vListRemove( &( pxCRCB->xEventListItem ) );
+			}
+		}
+		portEXIT_CRITICAL();
+
+		prvAddCoRoutineToReadyQueue( pxCRCB );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckDelayedList( void )
+{
+portTickType xTimeNow;
+xList portOBJECT_SPACE *pxTemp;
+
+	xTimeNow = xTaskGetTickCount();
+
+	if( xTimeNow != xCoRoutineTickCount )
+	{
+		/* The kernel tick count can only move forward by less than a full 
+		wrap between calls, so a lower count means it has wrapped.  Every 
+		co-routine still in the current list is then due, and the overflow 
+		list becomes the current list. */
+		if( xTimeNow < xCoRoutineTickCount )
+		{
+			prvWakeDelayedCoRoutines( xTimeNow, pdTRUE );
+
+			pxTemp = pxDelayedCoRoutineList;
+			pxDelayedCoRoutineList = pxOverflowDelayedCoRoutineList;
+			pxOverflowDelayedCoRoutineList = pxTemp;
+		}
+
+		xCoRoutineTickCount = xTimeNow;
+
+		prvWakeDelayedCoRoutines( xTimeNow, pdFALSE );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vCoRoutineSchedule( void )
+{
+xList portOBJECT_SPACE *pxReadyList;
+volatile xListItem portOBJECT_SPACE *pxItem;
+
+	/* Nothing to do until a co-routine has been created. */
+	if( pxCurrentCoRoutine == NULL )
+	{
+		return;
+	}
+
+	/* See if any co-routines readied by events need moving to the ready lists. */
+	prvCheckPendingReadyList();
+
+	/* See if any delayed co-routines have timed out. */
+	prvCheckDelayedList();
+
+	/* Find the highest priority queue that contains ready co-routines. */
+	while( listLIST_IS_EMPTY( &( pxReadyCoRoutineLists[ ucTopCoRoutineReadyPriority ] ) ) )
+	{
+		if( ucTopCoRoutineReadyPriority == ( unsigned portCHAR ) 0 )
+		{
+			/* No more co-routines to check. */
+			return;
+		}
+		--ucTopCoRoutineReadyPriority;
+	}
+
+	/* Co-routines of the same priority take turns.  This is 
+	listGET_OWNER_OF_NEXT_ENTRY(), which is written for task control blocks. */
+	pxReadyList = &( pxReadyCoRoutineLists[ ucTopCoRoutineReadyPriority ] );
+	pxItem = pxReadyList->pxIndex->pxNext;
+	if( pxItem == pxReadyList->pxHead )
+	{
+		pxItem = pxItem->pxNext;
+	}
+	pxReadyList->pxIndex = pxItem;
+	pxCurrentCoRoutine = ( corCRCB portOBJECT_SPACE * ) pxItem->pvOwner;
+
+	/* Call the co-routine. */
+	( pxCurrentCoRoutine->pxCoRoutineFunction )( pxCurrentCoRoutine, pxCurrentCoRoutine->ucIndex );
+}
+/*-----------------------------------------------------------*/
+
+signed portCHAR cCoRoutineRemoveFromEventList( const xList portOBJECT_SPACE *pxEventList )
+{
+corCRCB portOBJECT_SPACE *pxUnblockedCRCB;
+signed portCHAR cReturn;
+
+	/* This function is called from within an interrupt, or with interrupts 
+	disabled.  It can only access event lists and the pending ready list. */
+	pxUnblockedCRCB = ( corCRCB portOBJECT_SPACE * ) listGET_OWNER_OF_HEAD_ENTRY( pxEventList );
+	vListRemove( &( pxUnblockedCRCB->xEventListItem ) );
+	vListInsertEnd( ( xList portOBJECT_SPACE * ) &( xPendingReadyCoRoutineList ), &( pxUnblockedCRCB->xEventListItem ) );
+
+	if( pxUnblockedCRCB->ucPriority >= pxCurrentCoRoutine->ucPriority )
+	{
+		cReturn = pdTRUE;
+	}
+	else
+	{
+		cReturn = pdFALSE;
+	}
+
+	return cReturn;
+}
+/*-----------------------------------------------------------*/
+
+portTickType xCoRoutineGetExpectedIdleTime( void )
+{
+portTickType xReturn, xElapsed;
+unsigned portCHAR ucPriority;
+corCRCB portOBJECT_SPACE *pxCRCB;
+
+	/* THIS FUNCTION MUST BE CALLED WITH INTERRUPTS DISABLED. */
+
+	if( pxCurrentCoRoutine == NULL )
+	{
+		/* No co-routines have been created. */
+		return portMAX_DELAY;
+	}
+
+	if( !listLIST_IS_EMPTY( &xPendingReadyCoRoutineList ) )
+	{
+		return ( portTickType ) 0;
+	}
+
+	for( ucPriority = 0; ucPriority < portMAX_CO_ROUTINE_PRIORITIES; ucPriority++ )
+	{
+		if( !listLIST_IS_EMPTY( &( pxReadyCoRoutineLists[ ucPriority ] ) ) )
+		{
+			return ( portTickType ) 0;
+		}
+	}
+
+	/* The wake times are relative to the co-routine tick count, which may be 
+	behind the kernel tick count. */
+	xElapsed = ( portTickType ) ( xTaskGetTickCount() - xCoRoutineTickCount );
+
+	pxCRCB = ( corCRCB portOBJECT_SPACE * ) listGET_OWNER_OF_HEAD_ENTRY( pxDelayedCoRoutineList );
+	if( pxCRCB == NULL )
+	{
+		pxCRCB = ( corCRCB portOBJECT_SPACE * ) listGET_OWNER_OF_HEAD_ENTRY( pxOverflowDelayedCoRoutineList );
+	}
+
+	if( pxCRCB == NULL )
+	{
+		xReturn = portMAX_DELAY;
+	}
+	else
+	{
+		/* The subtraction also gives the right answer for a wake time in
+		the overflow list. */
+		xReturn = ( portTickType ) ( listGET_LIST_ITEM_VALUE( &( pxCRCB->xGenericListItem ) ) - xCoRoutineTickCount );
+
+		if( xReturn <= xElapsed )
+		{
+			xReturn = ( portTickType ) 0;
+		}
+		else
+		{
+			xReturn -= xElapsed;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInitialiseCoRoutineLists( void )
+{
+unsigned portCHAR ucPriority;
+
+	for( ucPriority = 0; ucPriority < portMAX_CO_ROUTINE_PRIORITIES; ucPriority++ )
+	{
+		vListInitialise( ( xList portOBJECT_SPACE * ) &( pxReadyCoRoutineLists[ ucPriority ] ) );
+	}
+
+	vListInitialise( ( xList portOBJECT_SPACE * ) &xDelayedCoRoutineList1 );
+	vListInitialise( ( xList portOBJECT_SPACE * ) &xDelayedCoRoutineList2 );
+	vListInitialise( ( xList portOBJECT_SPACE * ) &xPendingReadyCoRoutineList );
+
+	/* Start with pxDelayedCoRoutineList using list1 and the
+	pxOverflowDelayedCoRoutineList using list2. */
+	pxDelayedCoRoutineList = &xDelayedCoRoutineList1;
+	pxOverflowDelayedCoRoutineList = &xDelayedCoRoutineList2;
+
+	/* Start counting from the kernel tick count now, not from 0. */
+	xCoRoutineTickCount = xTaskGetTickCount();
+}
+
+#endif /* USE_CO_ROUTINES */
@@ -0,0 +1,340 @@
+/*
+	FreeRTOS V2.4.1 - Copyright (C) 2003, 2004 Richard Barry.
+
+	This file is part of the FreeRTOS distribution.
+
+	FreeRTOS is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	FreeRTOS is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with FreeRTOS; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+	A special exception to the GPL can be applied should you wish to distribute
+	a combined work that includes FreeRTOS, without being obliged to provide
+	the source code for any proprietary components.  See the licensing section 
+	of http://www.FreeRTOS.org for full details of how and when the exception
+	can be applied.
+
+	***************************************************************************
+	See http://www.FreeRTOS.org for documentation, latest information, license 
+	and contact details.  Please ensure to read the configuration and relevant 
+	port sections of the online documentation.
+	***************************************************************************
+*/
+
+/*
+ * Event groups.  Each event group is eight event bits and a list of the 
+ * tasks waiting for a combination of them.  The bits a task is waiting for,
+ * and how, are held in the event list item of the task, so the list need not
+ * be sorted - setting bits walks the whole list and wakes every task whose 
+ * condition is met.
+ *
+ * The lists are walked by ISRs as well as tasks, so are only ever accessed
+ * with interrupts disabled.
+ */
+
+#include <stdlib.h>
+#include "projdefs.h"
+#include "portable.h"
+#include "task.h"
+#include "list.h"
+#include "event_groups.h"
+
+#if USE_EVENT_GROUPS == 1
+
+#if( ( portMAX_EVENT_GROUPS < 1 ) || ( portMAX_EVENT_GROUPS > 8 ) )
+	#error "portMAX_EVENT_GROUPS must be between 1 and 8."
+#endif
+
+/* The high byte of the event list item value of a waiting task holds these
+control bits.  The low byte holds the event bits the task is waiting for
+while it waits, and the value of the event group when it is woken. */
+#define eventCLEAR_EVENTS_ON_EXIT_BIT	( ( portTickType ) 0x0100 )
+#define eventUNBLOCKED_DUE_TO_BIT_SET	( ( portTickType ) 0x0200 )
+#define eventWAIT_FOR_ALL_BITS			( ( portTickType ) 0x0400 )
+#define eventEVENT_BITS_MASK			( ( portTickType ) 0x00ff )
+
+/* The event bits of each event group.  These are the only part of an event
+group read by a task that does not block, so are placed in data memory. */
+static unsigned portCHAR portEVENT_BITS_DATA ucEventBits[ portMAX_EVENT_GROUPS ];
+
+/* The tasks waiting on each event group. */
+static xList portKERNEL_DATA xTasksWaitingForBits[ portMAX_EVENT_GROUPS ];
+
+/* One bit for each event group that has been created and not deleted. */
+static unsigned portCHAR portKERNEL_DATA ucGroupsInUse = ( unsigned portCHAR ) 0;
+
+/* Converts a handle to the index of the event group. */
+#define prvGroupIndex( xEventGroup )	( ( unsigned portCHAR ) ( ( xEventGroup ) - ( xEventGroupHandle ) 1 ) )
+
+/*
+ * Returns pdTRUE if ucCurrentEventBits meets the condition set by 
+ * ucBitsToWaitFor and cWaitForAllBits.
+ */
+static signed portCHAR prvTestWaitCondition( unsigned portCHAR ucCurrentEventBits, unsigned portCHAR ucBitsToWaitFor, signed portCHAR cWaitForAllBits );
+
+/*
+ * Sets bits in the event group and wakes the tasks whose condition is then 
+ * met.  Used by both ucEventGroupSetBits() and ucEventGroupSetBitsFromISR().
+ * MUST BE CALLED WITH INTERRUPTS DISABLED OR FROM AN ISR.
+ */
+static unsigned portCHAR prvSetBits( unsigned portCHAR ucGroup, unsigned portCHAR ucBitsToSet, signed portCHAR *pcTaskWoken );
+
+/*-----------------------------------------------------------
+ * PUBLIC EVENT GROUP API documented in event_groups.h
+ *----------------------------------------------------------*/
+
+xEventGroupHandle xEventGroupCreate( void )
+{
+xEventGroupHandle xReturn = eventINVALID_HANDLE;
+unsigned portCHAR ucGroup, ucGroupBit = ( unsigned portCHAR ) 1;
+
+	taskENTER_CRITICAL();
+	{
+		for( ucGroup = ( unsigned portCHAR ) 0; ucGroup < ( unsigned portCHAR ) portMAX_EVENT_GROUPS; ucGroup++ )
+		{
+			if( ( ucGroupsInUse & ucGroupBit ) == ( unsigned portCHAR ) 0 )
+			{
+				ucGroupsInUse |= ucGroupBit;
+				ucEventBits[ ucGroup ] = ( unsigned portCHAR ) 0;
+				vListInitialise( ( xList portOBJECT_SPACE * ) &( xTasksWaitingForBits[ ucGroup ] ) );
+				xReturn = ( xEventGroupHandle ) ( ucGroup + ( unsigned portCHAR ) 1 );
+				break;
+			}
+
+			ucGroupBit <<= 1;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+unsigned portCHAR ucEventGroupWaitBits( xEventGroupHandle xEventGroup, unsigned portCHAR ucBitsToWaitFor, signed portCHAR cClearOnExit, signed portCHAR cWaitForAllBits, portTickType xTicksToWait )
+{
+unsigned portCHAR ucGroup = prvGroupIndex( xEventGroup );
+unsigned portCHAR ucReturn;
+signed portCHAR cBlocked = ( signed portCHAR ) pdFALSE;
+portTickType xControlBits;
+
+	taskENTER_CRITICAL();
+	{
+		ucReturn = ucEventBits[ ucGroup ];
+
+		if( prvTestWaitCondition( ucReturn, ucBitsToWaitFor, cWaitForAllBits ) != ( signed portCHAR ) pdFALSE )
+		{
+			/* The wait condition has already been met so there is no need 
+			to block. */
+			if( cClearOnExit != ( signed portCHAR ) pdFALSE )
+			{
+				ucEventBits[ ucGroup ] &= ~ucBitsToWaitFor;
+			}
+		}
+		else if( xTicksToWait > ( portTickType ) 0 )
+		{
+			/* Store the bits the task is waiting for, and how, in its event
+			list item so prvSetBits() can test them. */
+			xControlBits = ( portTickType ) ucBitsToWaitFor;
+			if( cClearOnExit != ( signed portCHAR ) pdFALSE )
+			{
+				xControlBits |= eventCLEAR_EVENTS_ON_EXIT_BIT;
+			}
+			if( cWaitForAllBits != ( signed portCHAR ) pdFALSE )
+			{
+				xControlBits |= eventWAIT_FOR_ALL_BITS;
+			}
+
+			vTaskPlaceOnUnorderedEventList( ( xList portOBJECT_SPACE * ) &( xTasksWaitingForBits[ ucGroup ] ), xControlBits, xTicksToWait );
+			cBlocked = ( signed portCHAR ) pdTRUE;
+
+			/* The task runs again once the condition is met or the timeout 
+			expires. */
+			taskYIELD();
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	if( cBlocked != ( signed portCHAR ) pdFALSE )
+	{
+		taskENTER_CRITICAL();
+		{
+			xControlBits = xTaskResetEventItemValue();
+
+			if( ( xControlBits & eventUNBLOCKED_DUE_TO_BIT_SET ) != ( portTickType ) 0 )
+			{
+				/* The task was woken by prvSetBits(), which has already 
+				cleared the bits if requested. */
+				ucReturn = ( unsigned portCHAR ) ( xControlBits & eventEVENT_BITS_MASK );
+			}
+			else
+			{
+				/* The timeout expired, but the bits could have been set 
+				since the task was woken. */
+				ucReturn = ucEventBits[ ucGroup ];
+
+				if( prvTestWaitCondition( ucReturn, ucBitsToWaitFor, cWaitForAllBits ) != ( signed portCHAR ) pdFALSE )
+				{
+					if( cClearOnExit != ( signed portCHAR ) pdFALSE )
+					{
+						ucEventBits[ ucGroup ] &= ~ucBitsToWaitFor;
+					}
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+
+	return ucReturn;
+}
+/*-----------------------------------------------------------*/
+
+unsigned portCHAR ucEventGroupSetBits( xEventGroupHandle xEventGroup, unsigned portCHAR ucBitsToSet )
+{
+unsigned portCHAR ucReturn;
+signed portCHAR cTaskWoken = ( signed portCHAR ) pdFALSE;
+
+	taskENTER_CRITICAL();
+	{
+		ucReturn = prvSetBits( prvGroupIndex( xEventGroup ), ucBitsToSet, &cTaskWoken );
+	}
+	taskEXIT_CRITICAL();
+
+	if( cTaskWoken != ( signed portCHAR ) pdFALSE )
+	{
+		taskYIELD();
+	}
+
+	return ucReturn;
+}
+/*-----------------------------------------------------------*/
+
+unsigned portCHAR ucEventGroupSetBitsFromISR( xEventGroupHandle xEventGroup, unsigned portCHAR ucBitsToSet, signed portCHAR *pcTaskWoken )
+{
+	return prvSetBits( prvGroupIndex( xEventGroup ), ucBitsToSet, pcTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+unsigned portCHAR ucEventGroupClearBits( xEventGroupHandle xEventGroup, unsigned portCHAR ucBitsToClear )
+{
+unsigned portCHAR ucGroup = prvGroupIndex( xEventGroup );
+unsigned portCHAR ucReturn;
+
+	taskENTER_CRITICAL();
+	{
+		ucReturn = ucEventBits[ ucGroup ];
+		ucEventBits[ ucGroup ] &= ~ucBitsToClear;
+	}
+	taskEXIT_CRITICAL();
+
+	return ucReturn;
+}
+/*-----------------------------------------------------------*/
+
+unsigned portCHAR ucEventGroupGetBits( xEventGroupHandle xEventGroup )
+{
+	/* A single byte read cannot be interrupted part way through. */
+	return ucEventBits[ prvGroupIndex( xEventGroup ) ];
+}
+/*-----------------------------------------------------------*/
+
+void vEventGroupDelete( xEventGroupHandle xEventGroup )
+{
+unsigned portCHAR ucGroup = prvGroupIndex( xEventGroup );
+xList portOBJECT_SPACE *pxWaitingTasks = ( xList portOBJECT_SPACE * ) &( xTasksWaitingForBits[ ucGroup ] );
+signed portCHAR cTaskWoken = ( signed portCHAR ) pdFALSE;
+
+	taskENTER_CRITICAL();
+	{
+		/* Wake the waiting tasks with an event group value of 0. */
+		while( !listLIST_IS_EMPTY( pxWaitingTasks ) )
+		{
+			if( cTaskRemoveFromUnorderedEventList( ( xListItem portOBJECT_SPACE * ) pxWaitingTasks->pxHead->pxNext, eventUNBLOCKED_DUE_TO_BIT_SET ) != ( signed portCHAR ) pdFALSE )
+			{
+				cTaskWoken = ( signed portCHAR ) pdTRUE;
+			}
+		}
+
+		ucGroupsInUse &= ~( unsigned portCHAR ) ( ( unsigned portCHAR ) 1 << ucGroup );
+	}
+	taskEXIT_CRITICAL();
+
+	if( cTaskWoken != ( signed portCHAR ) pdFALSE )
+	{
+		taskYIELD();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static unsigned portCHAR prvSetBits( unsigned portCHAR ucGroup, unsigned portCHAR ucBitsToSet, signed portCHAR *pcTaskWoken )
+{
+xList portOBJECT_SPACE *pxWaitingTasks = ( xList portOBJECT_SPACE * ) &( xTasksWaitingForBits[ ucGroup ] );
+volatile xListItem portOBJECT_SPACE *pxListItem;
+volatile xListItem portOBJECT_SPACE *pxNext;
+portTickType xControlBits;
+unsigned portCHAR ucCurrentEventBits, ucBitsToWaitFor, ucBitsToClear = ( unsigned portCHAR ) 0;
+
+	ucEventBits[ ucGroup ] |= ucBitsToSet;
+	ucCurrentEventBits = ucEventBits[ ucGroup ];
+
+	/* Test the condition of every waiting task against the new value.  The
+	next item is noted first as a task that is woken leaves the list. */
+	pxListItem = pxWaitingTasks->pxHead->pxNext;
+	while( pxListItem != pxWaitingTasks->pxHead )
+	{
+		pxNext = pxListItem->pxNext;
+		xControlBits = listGET_LIST_ITEM_VALUE( pxListItem );
+		ucBitsToWaitFor = ( unsigned portCHAR ) ( xControlBits & eventEVENT_BITS_MASK );
+
+		if( prvTestWaitCondition( ucCurrentEventBits, ucBitsToWaitFor, ( ( xControlBits & eventWAIT_FOR_ALL_BITS ) != ( portTickType ) 0 ) ) != ( signed portCHAR ) pdFALSE )
+		{
+			/* The bits are cleared once every task has been tested, so all
+			the tasks waiting for the same bits are woken. */
+			if( ( xControlBits & eventCLEAR_EVENTS_ON_EXIT_BIT ) != ( portTickType ) 0 )
+			{
+				ucBitsToClear |= ucBitsToWaitFor;
+			}
+
+			/* The task is told the value of the event group that woke it. */
+			if( cTaskRemoveFromUnorderedEventList( ( xListItem portOBJECT_SPACE * ) pxListItem, ( portTickType ) ucCurrentEventBits | eventUNBLOCKED_DUE_TO_BIT_SET ) != ( signed portCHAR ) pdFALSE )
+			{
+				*pcTaskWoken = ( signed portCHAR ) pdTRUE;
+			}
+		}
+
+		pxListItem = pxNext;
+	}
+
+	ucEventBits[ ucGroup ] &= ~ucBitsToClear;
+
+	return ucEventBits[ ucGroup ];
+}
+/*-----------------------------------------------------------*/
+
+static signed portCHAR prvTestWaitCondition( unsigned portCHAR ucCurrentEventBits, unsigned portCHAR ucBitsToWaitFor, signed portCHAR cWaitForAllBits )
+{
+signed portCHAR cReturn;
+
+	if( cWaitForAllBits == ( signed portCHAR ) pdFALSE )
+	{
+		/* Any one of the bits will do. */
+		cReturn = ( ( ucCurrentEventBits & ucBitsToWaitFor ) != ( unsigned portCHAR ) 0 );
+	}
+	else
+	{
+		/* Every bit must be set. */
+		cReturn = ( ( ucCurrentEventBits & ucBitsToWaitFor ) == ucBitsToWaitFor );
+	}
+
+	return cReturn;
+}
+
+#endif /* USE_EVENT_GROUPS */
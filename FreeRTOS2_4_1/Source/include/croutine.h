@@ -0,0 +1,454 @@
+/*
+	FreeRTOS V2.4.1 - Copyright (C) 2003, 2004 Richard Barry.
+
+	This file is part of the FreeRTOS distribution.
+
+	FreeRTOS is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	FreeRTOS is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with FreeRTOS; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+	A special exception to the GPL can be applied should you wish to distribute
+	a combined work that includes FreeRTOS, without being obliged to provide
+	the source code for any proprietary components.  See the licensing section 
+	of http://www.FreeRTOS.org for full details of how and when the exception
+	can be applied.
+
+	***************************************************************************
+	See http://www.FreeRTOS.org for documentation, latest information, license 
+	and contact details.  Please ensure to read the configuration and relevant 
+	port sections of the online documentation.
+	***************************************************************************
+*/
+
+#ifndef CO_ROUTINE_H
+#define CO_ROUTINE_H
+
+#include "portable.h"
+#include "list.h"
+
+/*-----------------------------------------------------------
+ * MACROS AND DEFINITIONS
+ *----------------------------------------------------------*/
+
+/*
+ * Co-routines are a light weight alternative to tasks.  They are written as
+ * a switch statement (hidden by the crSTART() and crEND() macros) so can
+ * block and resume without a stack of their own.  All the co-routines share
+ * the stack of the idle task, which runs them by calling vCoRoutineSchedule()
+ * when USE_CO_ROUTINES is 1, so switching between co-routines involves no 
+ * stack copying at all.
+ *
+ * This has consequences for how a co-routine is written:
+ *
+ * + Local variables do not keep their value when the co-routine blocks, so
+ *   any variable that must do so has to be declared static.
+ *
+ * + The blocking macros (crDELAY(), crQUEUE_SEND() and crQUEUE_RECEIVE()) can
+ *   only be used from within the co-routine function itself, not from a 
+ *   function it calls, and not from within a switch statement.
+ *
+ * Co-routines are scheduled cooperatively amongst themselves, by priority. 
+ * A co-routine only runs when no task other than the idle task is able to.
+ */
+
+/**
+ * croutine. h
+ *
+ * Type by which co-routines are referenced.  The co-routine function is 
+ * passed its own handle, which it passes in turn to the co-routine macros.
+ *
+ * \page xCoRoutineHandle xCoRoutineHandle
+ * \ingroup Tasks
+ */
+typedef void portOBJECT_SPACE * xCoRoutineHandle;
+
+/* Defines the prototype to which co-routine functions must conform. */
+typedef void (*crCOROUTINE_CODE)( xCoRoutineHandle, unsigned portCHAR );
+
+/* The co-routine control block.  Only accessed through the macros and 
+functions below. */
+typedef struct corCoRoutineControlBlock
+{
+	crCOROUTINE_CODE pxCoRoutineFunction;
+	xListItem xGenericListItem;				/*< List item used to place the CRCB in ready and blocked queues. */
+	xListItem xEventListItem;				/*< List item used to place the CRCB in event lists. */
+	unsigned portCHAR ucPriority;			/*< The priority of the co-routine in relation to other co-routines. */
+	unsigned portCHAR ucIndex;				/*< Used to distinguish between co-routines when multiple co-routines use the same co-routine function. */
+	unsigned portSHORT usState;				/*< Used internally by the co-routine implementation. */
+} corCRCB;
+
+/**
+ * croutine. h
+ *<pre>
+ signed portCHAR cCoRoutineCreate( 
+                                   crCOROUTINE_CODE pxCoRoutineCode, 
+                                   unsigned portCHAR ucPriority, 
+                                   unsigned portCHAR ucIndex 
+                                 );</pre>
+ *
+ * Create a new co-routine and add it to the list of co-routines that are 
+ * ready to run.
+ *
+ * @param pxCoRoutineCode Pointer to the co-routine function.  Co-routine 
+ * functions require special syntax - see the example below.
+ *
+ * @param ucPriority The priority with respect to other co-routines at which
+ * the co-routine will run.  Limited to portMAX_CO_ROUTINE_PRIORITIES - 1.
+ *
+ * @param ucIndex Used to distinguish between different co-routines that 
+ * execute the same function.  See the example below.
+ *
+ * @return pdPASS if the co-routine was successfully created, otherwise 
+ * errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY.
+ *
+ * Example usage:
+   <pre>
+ // Co-routine to be created.
+ void vFlashCoRoutine( xCoRoutineHandle xHandle, unsigned portCHAR ucIndex )
+ {
+ // Variables in co-routines must be declared static if they must maintain
+ // their value when the co-routine blocks.
+ static const portTickType xFlashRates[ 2 ] = { 200, 400 };
+
+    // Must start every co-routine with a call to crSTART();
+    crSTART( xHandle );
+
+    for( ;; )
+    {
+        // This co-routine just delays for a fixed period, then toggles
+        // an LED.  Two co-routines are created using this function, so
+        // the ucIndex parameter is used to tell the co-routine which
+        // LED to flash and how long to delay.
+        crDELAY( xHandle, xFlashRates[ ucIndex ] );
+        vParTestToggleLED( ucIndex );
+    }
+
+    // Must end every co-routine with a call to crEND();
+    crEND();
+ }
+
+ // Function that creates two co-routines.
+ void vOtherFunction( void )
+ {
+ unsigned portCHAR ucIndex;
+
+    // Create two co-routines at priority 0.  The first is given index 0
+    // so (from the code above) toggles LED 0 every 200 ticks.  The second
+    // is given index 1 so toggles LED 1 every 400 ticks.
+    for( ucIndex = 0; ucIndex < 2; ucIndex++ )
+    {
+        cCoRoutineCreate( vFlashCoRoutine, 0, ucIndex );
+    }
+ }
+   </pre>
+ * \defgroup cCoRoutineCreate cCoRoutineCreate
+ * \ingroup Tasks
+ */
+signed portCHAR cCoRoutineCreate( crCOROUTINE_CODE pxCoRoutineCode, unsigned portCHAR ucPriority, unsigned portCHAR ucIndex );
+
+/**
+ * croutine. h
+ *<pre>
+ void vCoRoutineSchedule( void );</pre>
+ *
+ * Run the highest priority co-routine that is able to run, until it blocks
+ * or yields.  Co-routines of equal priority take turns.  Called repeatedly 
+ * by the idle task when USE_CO_ROUTINES is 1, but could equally be called 
+ * from a task of the application's own - though only ever from one task.
+ *
+ * \defgroup vCoRoutineSchedule vCoRoutineSchedule
+ * \ingroup Tasks
+ */
+void vCoRoutineSchedule( void );
+
+/**
+ * croutine. h
+ * <pre>
+ crSTART( xCoRoutineHandle xHandle );</pre>
+ *
+ * This macro MUST always be called at the start of a co-routine function.
+ * See cCoRoutineCreate() for an example.
+ *
+ * \defgroup crSTART crSTART
+ * \ingroup Tasks
+ */
+#define crSTART( pxCRCB ) switch( ( ( corCRCB portOBJECT_SPACE * ) ( pxCRCB ) )->usState ) { case 0:
+
+/**
+ * croutine. h
+ * <pre>
+ crEND();</pre>
+ *
+ * This macro MUST always be called at the end of a co-routine function.
+ *
+ * \defgroup crEND crEND
+ * \ingroup Tasks
+ */
+#define crEND() }
+
+/*
+ * These macros are intended for internal use by the co-routine macros only.
+ * The macro nature of the co-routines mean that the prototypes for these 
+ * macros must be in this file.  Each records the point at which the 
+ * co-routine is to resume - the line number - and returns.
+ */
+#define crSET_STATE0( xHandle ) ( ( corCRCB portOBJECT_SPACE * ) ( xHandle ) )->usState = ( unsigned portSHORT ) ( __LINE__ * 2 ); return; case ( __LINE__ * 2 ):
+#define crSET_STATE1( xHandle ) ( ( corCRCB portOBJECT_SPACE * ) ( xHandle ) )->usState = ( unsigned portSHORT ) ( ( __LINE__ * 2 ) + 1 ); return; case ( ( __LINE__ * 2 ) + 1 ):
+
+/**
+ * croutine. h
+ *<pre>
+ crDELAY( xCoRoutineHandle xHandle, portTickType xTicksToDelay );</pre>
+ *
+ * Delay a co-routine for a fixed period of time.  crDELAY() can only be 
+ * called from the co-routine function itself - not from within a function
+ * called by the co-routine function.  This is because co-routines do not 
+ * maintain their own stack.
+ *
+ * @param xHandle The handle of the co-routine to delay.  This is the xHandle
+ * parameter of the co-routine function.
+ *
+ * @param xTicksToDelay The number of ticks that the co-routine should delay
+ * for.  The constant portTICKS_PER_MS can be used to convert to real time.
+ * A delay of 0 just lets the other ready co-routines run.
+ *
+ * \defgroup crDELAY crDELAY
+ * \ingroup Tasks
+ */
+#define crDELAY( xHandle, xTicksToDelay )												\
+	if( ( xTicksToDelay ) > ( portTickType ) 0 )										\
+	{																					\
+		vCoRoutineAddToDelayedList( ( xTicksToDelay ), NULL );							\
+	}																					\
+	crSET_STATE0( ( xHandle ) );
+
+/**
+ * croutine. h
+ * <pre>
+ crQUEUE_SEND(
+                  xCoRoutineHandle xHandle,
+                  xQueueHandle pxQueue,
+                  void *pvItemToQueue,
+                  portTickType xTicksToWait,
+                  signed portCHAR *pcResult
+             )</pre>
+ *
+ * The macro's equivalent to cQueueSend() for use by co-routines.  As 
+ * crDELAY(), crQUEUE_SEND() can only be called from the co-routine function
+ * itself.
+ *
+ * The queue functions called by the macros are declared in queue.h, which
+ * must be included first.
+ *
+ * Co-routines and tasks cannot wait on the same queue.  A queue used by 
+ * co-routines can be written to and read from by ISRs, but only with the 
+ * crQUEUE_SEND_FROM_ISR() and crQUEUE_RECEIVE_FROM_ISR() macros.
+ *
+ * @param xHandle The handle of the calling co-routine.
+ *
+ * @param pxQueue The handle of the queue on which the data will be posted.
+ *
+ * @param pvItemToQueue A pointer to the data being posted onto the queue.
+ * The item is copied into the queue so should be in a static variable, or
+ * a constant.
+ *
+ * @param xTicksToWait The number of ticks for which the co-routine should 
+ * block to wait for space to become available on the queue, should space not
+ * be available immediately.
+ *
+ * @param pcResult The variable pointed to by pcResult will be set to pdPASS
+ * if data was successfully posted onto the queue, otherwise it will be set to
+ * an error defined within errors.h.
+ *
+ * Example usage:
+   <pre>
+ // A co-routine that posts a number every 200 ticks.
+ void vSendingCoRoutine( xCoRoutineHandle xHandle, unsigned portCHAR ucIndex )
+ {
+ static portSHORT sNumberToPost = 0;
+ static signed portCHAR cResult;
+
+    crSTART( xHandle );
+
+    for( ;; )
+    {
+        // This assumes the queue has already been created.
+        crQUEUE_SEND( xHandle, xCoRoutineQueue, &sNumberToPost, 0, &cResult );
+
+        if( cResult != pdPASS )
+        {
+            // The message was not posted!
+        }
+
+        sNumberToPost++;
+        crDELAY( xHandle, 200 );
+    }
+
+    crEND();
+ }
+   </pre>
+ * \defgroup crQUEUE_SEND crQUEUE_SEND
+ * \ingroup Tasks
+ */
+#define crQUEUE_SEND( xHandle, pxQueue, pvItemToQueue, xTicksToWait, pcResult )		\
+{																						\
+	*( pcResult ) = cQueueCRSend( ( pxQueue ), ( pvItemToQueue ), ( xTicksToWait ) );	\
+	if( *( pcResult ) == errQUEUE_BLOCKED )												\
+	{																					\
+		crSET_STATE0( ( xHandle ) );													\
+		*( pcResult ) = cQueueCRSend( ( pxQueue ), ( pvItemToQueue ), ( portTickType ) 0 );	\
+	}																					\
+	if( *( pcResult ) == errQUEUE_YIELD )												\
+	{																					\
+		crSET_STATE1( ( xHandle ) );													\
+		*( pcResult ) = pdPASS;															\
+	}																					\
+}
+
+/**
+ * croutine. h
+ * <pre>
+ crQUEUE_RECEIVE(
+                     xCoRoutineHandle xHandle,
+                     xQueueHandle pxQueue,
+                     void *pvBuffer,
+                     portTickType xTicksToWait,
+                     signed portCHAR *pcResult
+                 )</pre>
+ *
+ * The macro's equivalent to cQueueReceive() for use by co-routines.  The
+ * same restrictions apply as to crQUEUE_SEND().
+ *
+ * @param xHandle The handle of the calling co-routine.
+ *
+ * @param pxQueue The handle of the queue from which the data will be 
+ * received.
+ *
+ * @param pvBuffer The buffer into which the received item is copied.
+ *
+ * @param xTicksToWait The number of ticks for which the co-routine should 
+ * block to wait for data to become available, should data not be available
+ * immediately.
+ *
+ * @param pcResult The variable pointed to by pcResult will be set to pdPASS
+ * if data was successfully retrieved from the queue, otherwise it will be 
+ * set to an error code as defined within errors.h.
+ *
+ * \defgroup crQUEUE_RECEIVE crQUEUE_RECEIVE
+ * \ingroup Tasks
+ */
+#define crQUEUE_RECEIVE( xHandle, pxQueue, pvBuffer, xTicksToWait, pcResult )			\
+{																						\
+	*( pcResult ) = cQueueCRReceive( ( pxQueue ), ( pvBuffer ), ( xTicksToWait ) );	\
+	if( *( pcResult ) == errQUEUE_BLOCKED ) 											\
+	{																					\
+		crSET_STATE0( ( xHandle ) );													\
+		*( pcResult ) = cQueueCRReceive( ( pxQueue ), ( pvBuffer ), ( portTickType ) 0 );	\
+	}																					\
+	if( *( pcResult ) == errQUEUE_YIELD )												\
+	{																					\
+		crSET_STATE1( ( xHandle ) );													\
+		*( pcResult ) = pdPASS;															\
+	}																					\
+}
+
+/**
+ * croutine. h
+ * <pre>
+ crQUEUE_SEND_FROM_ISR(
+                            xQueueHandle pxQueue,
+                            void *pvItemToQueue,
+                            signed portCHAR cCoRoutinePreviouslyWoken
+                       )</pre>
+ *
+ * The macro's equivalent to cQueueSendFromISR() for use by ISRs that post
+ * to a queue used by co-routines.  
+ *
+ * @param pxQueue The handle to the queue on which the item is to be posted.
+ *
+ * @param pvItemToQueue A pointer to the item that is to be placed on the 
+ * queue.
+ *
+ * @param cCoRoutinePreviouslyWoken This is included so an ISR can post onto
+ * the same queue multiple times from a single interrupt.  The first call
+ * should always pass in pdFALSE.  Subsequent calls should pass in
+ * the value returned from the previous call.
+ *
+ * @return pdTRUE if a co-routine was woken by posting onto the queue.  The
+ * co-routine runs the next time vCoRoutineSchedule() is called, so no 
+ * context switch is requested.
+ *
+ * \defgroup crQUEUE_SEND_FROM_ISR crQUEUE_SEND_FROM_ISR
+ * \ingroup Tasks
+ */
+#define crQUEUE_SEND_FROM_ISR( pxQueue, pvItemToQueue, cCoRoutinePreviouslyWoken ) cQueueCRSendFromISR( ( pxQueue ), ( pvItemToQueue ), ( cCoRoutinePreviouslyWoken ) )
+
+/**
+ * croutine. h
+ * <pre>
+ crQUEUE_RECEIVE_FROM_ISR(
+                               xQueueHandle pxQueue,
+                               void *pvBuffer,
+                               signed portCHAR *pcCoRoutineWoken
+                          )</pre>
+ *
+ * The macro's equivalent to cQueueReceiveFromISR() for use by ISRs that 
+ * read from a queue used by co-routines.
+ *
+ * @param pxQueue The handle to the queue from which the item is to be read.
+ *
+ * @param pvBuffer A pointer to a buffer into which the received item will be
+ * copied.
+ *
+ * @param pcCoRoutineWoken Should be set to pdFALSE before the first call
+ * within an ISR.  Set to pdTRUE if a co-routine waiting for space on the 
+ * queue was woken.
+ *
+ * @return pdTRUE if an item was successfully received from the queue, 
+ * otherwise pdFALSE.
+ *
+ * \defgroup crQUEUE_RECEIVE_FROM_ISR crQUEUE_RECEIVE_FROM_ISR
+ * \ingroup Tasks
+ */
+#define crQUEUE_RECEIVE_FROM_ISR( pxQueue, pvBuffer, pcCoRoutineWoken ) cQueueCRReceiveFromISR( ( pxQueue ), ( pvBuffer ), ( pcCoRoutineWoken ) )
+
+/*
+ * This function is intended for internal use by the co-routine macros only.
+ * The macro nature of the co-routine implementation requires that the
+ * prototype appears here.  The function should not be used by application
+ * writers.
+ *
+ * Removes the current co-routine from its ready list and places it in the
+ * appropriate delayed list, and in pxEventList if it is not NULL.
+ */
+void vCoRoutineAddToDelayedList( portTickType xTicksToDelay, xList portOBJECT_SPACE *pxEventList );
+
+/*
+ * This function is intended for internal use by the queue implementation only.
+ * The function should not be used by application writers.
+ *
+ * Removes the highest priority co-routine from the event list and places it
+ * in the pending ready list.  Returns pdTRUE if it has a priority no lower 
+ * than that of the current co-routine.
+ */
+signed portCHAR cCoRoutineRemoveFromEventList( const xList portOBJECT_SPACE *pxEventList );
+
+/*
+ * Used by xTaskGetExpectedIdleTime() so the idle task does not suppress the
+ * tick past the time a delayed co-routine is due to wake.  MUST BE CALLED 
+ * WITH INTERRUPTS DISABLED.
+ */
+portTickType xCoRoutineGetExpectedIdleTime( void );
+
+#endif /* CO_ROUTINE_H */
+
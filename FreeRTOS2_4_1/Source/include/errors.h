@@ -36,6 +36,8 @@
 #define errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY	( -1 )
 #define errNO_TASK_TO_RUN						( -2 )
 #define errQUEUE_FULL							( -3 )
+#define errQUEUE_BLOCKED						( -4 )
+#define errQUEUE_YIELD							( -5 )
 
 #endif
 
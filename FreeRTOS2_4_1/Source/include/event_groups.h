@@ -0,0 +1,303 @@
+/*
+	FreeRTOS V2.4.1 - Copyright (C) 2003, 2004 Richard Barry.
+
+	This file is part of the FreeRTOS distribution.
+
+	FreeRTOS is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	FreeRTOS is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with FreeRTOS; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+	A special exception to the GPL can be applied should you wish to distribute
+	a combined work that includes FreeRTOS, without being obliged to provide
+	the source code for any proprietary components.  See the licensing section 
+	of http://www.FreeRTOS.org for full details of how and when the exception
+	can be applied.
+
+	***************************************************************************
+	See http://www.FreeRTOS.org for documentation, latest information, license 
+	and contact details.  Please ensure to read the configuration and relevant 
+	port sections of the online documentation.
+	***************************************************************************
+*/
+
+#ifndef EVENT_GROUPS_H
+#define EVENT_GROUPS_H
+
+/*-----------------------------------------------------------
+ * MACROS AND DEFINITIONS
+ *----------------------------------------------------------*/
+
+/*
+ * An event group is a set of eight event flags (bits) that tasks can block 
+ * on.  A task can wait for any one of a number of bits to be set, or for all
+ * of them, so can wait on a combination of conditions - a frame being ready,
+ * a timeout flag or a shutdown request, say - without polling a number of 
+ * queues or semaphores.  Setting bits wakes every task whose condition is 
+ * then met.
+ *
+ * The event groups are not allocated from the heap.  portMAX_EVENT_GROUPS 
+ * groups are declared within event_groups.c, with the event bits of each in
+ * portEVENT_BITS_DATA memory, and a handle is just the number of the group.
+ */
+
+/**
+ * event_groups. h
+ *
+ * Type by which event groups are referenced.  For example, a call to 
+ * xEventGroupCreate() returns an xEventGroupHandle that can then be used as
+ * a parameter to ucEventGroupWaitBits(), ucEventGroupSetBits(), etc.
+ *
+ * \page xEventGroupHandle xEventGroupHandle
+ * \ingroup EventGroup
+ */
+typedef unsigned portCHAR xEventGroupHandle;
+
+/*
+ * The handle returned by xEventGroupCreate() when every event group is 
+ * already in use.
+ */
+#define eventINVALID_HANDLE			( ( xEventGroupHandle ) 0 )
+
+/**
+ * event_groups. h
+ *<pre>
+ xEventGroupHandle xEventGroupCreate( void );</pre>
+ *
+ * Create a new event group, with all its event bits clear.
+ *
+ * @return The handle of the event group, or eventINVALID_HANDLE if all
+ * portMAX_EVENT_GROUPS event groups are already in use.
+ *
+ * Example usage:
+   <pre>
+ xEventGroupHandle xEventGroup;
+
+    // Attempt to create the event group.
+    xEventGroup = xEventGroupCreate();
+
+    if( xEventGroup == eventINVALID_HANDLE )
+    {
+        // The event group was not created - portMAX_EVENT_GROUPS is too low.
+    }
+   </pre>
+ * \defgroup xEventGroupCreate xEventGroupCreate
+ * \ingroup EventGroup
+ */
+xEventGroupHandle xEventGroupCreate( void );
+
+/**
+ * event_groups. h
+ *<pre>
+ unsigned portCHAR ucEventGroupWaitBits( 
+                                          xEventGroupHandle xEventGroup,
+                                          unsigned portCHAR ucBitsToWaitFor,
+                                          signed portCHAR cClearOnExit,
+                                          signed portCHAR cWaitForAllBits,
+                                          portTickType xTicksToWait
+                                       );</pre>
+ *
+ * Read bits within an event group, optionally entering the Blocked state
+ * (with a timeout) to wait for a bit or group of bits to become set.
+ *
+ * This function cannot be called from an interrupt.
+ *
+ * @param xEventGroup The event group in which the bits are being tested.
+ *
+ * @param ucBitsToWaitFor A bitwise value that indicates the bit or bits to 
+ * test inside the event group.  Must not be 0.
+ *
+ * @param cClearOnExit If pdTRUE then ucBitsToWaitFor are cleared in the 
+ * event group before the function returns, provided the wait condition was
+ * met.  If pdFALSE the bits are not changed.
+ *
+ * @param cWaitForAllBits If pdTRUE the function returns when all the bits in
+ * ucBitsToWaitFor are set (or the timeout expires).  If pdFALSE the function
+ * returns when any of the bits in ucBitsToWaitFor is set (or the timeout
+ * expires).
+ *
+ * @param xTicksToWait The maximum number of ticks to wait for the condition
+ * to be met.
+ *
+ * @return The value of the event group when the condition was met, before 
+ * any bits were cleared, or the value of the event group when the timeout
+ * expired.  Test the returned value to know which bits were set - if the 
+ * timeout expired the condition will not be met by the returned value.
+ *
+ * Example usage:
+   <pre>
+ #define BIT_0 ( 1 << 0 )
+ #define BIT_4 ( 1 << 4 )
+
+ void aFunction( xEventGroupHandle xEventGroup )
+ {
+ unsigned portCHAR ucBits;
+
+    // Wait a maximum of 100 ticks for either bit 0 or bit 4 to be set within
+    // the event group.  Clear the bits before exiting.
+    ucBits = ucEventGroupWaitBits(
+                xEventGroup,     // The event group being tested.
+                BIT_0 | BIT_4,   // The bits within the event group to wait for.
+                pdTRUE,          // BIT_0 and BIT_4 should be cleared before returning.
+                pdFALSE,         // Don't wait for both bits, either bit will do.
+                100 );           // Wait a maximum of 100 ticks for either bit to be set.
+
+    if( ( ucBits & ( BIT_0 | BIT_4 ) ) == ( BIT_0 | BIT_4 ) )
+    {
+        // ucEventGroupWaitBits() returned because both bits were set.
+    }
+    else if( ( ucBits & BIT_0 ) != 0 )
+    {
+        // ucEventGroupWaitBits() returned because just BIT_0 was set.
+    }
+    else if( ( ucBits & BIT_4 ) != 0 )
+    {
+        // ucEventGroupWaitBits() returned because just BIT_4 was set.
+    }
+    else
+    {
+        // ucEventGroupWaitBits() returned because 100 ticks passed without
+        // either BIT_0 or BIT_4 becoming set.
+    }
+ }
+   </pre>
+ * \defgroup ucEventGroupWaitBits ucEventGroupWaitBits
+ * \ingroup EventGroup
+ */
+unsigned portCHAR ucEventGroupWaitBits( xEventGroupHandle xEventGroup, unsigned portCHAR ucBitsToWaitFor, signed portCHAR cClearOnExit, signed portCHAR cWaitForAllBits, portTickType xTicksToWait );
+
+/**
+ * event_groups. h
+ *<pre>
+ unsigned portCHAR ucEventGroupSetBits( xEventGroupHandle xEventGroup, unsigned portCHAR ucBitsToSet );</pre>
+ *
+ * Set bits within an event group, waking every task that was waiting for 
+ * the bits.  This function cannot be called from an interrupt - see 
+ * ucEventGroupSetBitsFromISR().
+ *
+ * @param xEventGroup The event group in which the bits are to be set.
+ *
+ * @param ucBitsToSet A bitwise value that indicates the bit or bits to set.
+ *
+ * @return The value of the event group once the bits have been set and any
+ * bits to be cleared on exit by the tasks that were woken have been cleared.
+ *
+ * Example usage:
+   <pre>
+ #define BIT_0 ( 1 << 0 )
+
+ void vUARTTask( void * pvParameters )
+ {
+    for( ;; )
+    {
+        // ... receive a frame ...
+
+        // Tell the tasks waiting on the group that a frame is ready.
+        ucEventGroupSetBits( xEventGroup, BIT_0 );
+    }
+ }
+   </pre>
+ * \defgroup ucEventGroupSetBits ucEventGroupSetBits
+ * \ingroup EventGroup
+ */
+unsigned portCHAR ucEventGroupSetBits( xEventGroupHandle xEventGroup, unsigned portCHAR ucBitsToSet );
+
+/**
+ * event_groups. h
+ *<pre>
+ unsigned portCHAR ucEventGroupSetBitsFromISR( xEventGroupHandle xEventGroup, unsigned portCHAR ucBitsToSet, signed portCHAR *pcTaskWoken );</pre>
+ *
+ * A version of ucEventGroupSetBits() that can be called from an ISR.  The
+ * tasks waiting for the bits are woken from within the ISR, so the time 
+ * taken depends on the number of tasks waiting on the event group.
+ *
+ * @param xEventGroup The event group in which the bits are to be set.
+ *
+ * @param ucBitsToSet A bitwise value that indicates the bit or bits to set.
+ *
+ * @param pcTaskWoken Set to pdTRUE if setting the bits woke a task with a 
+ * priority higher than the task that was interrupted, in which case a 
+ * context switch should be requested before the ISR exits.  It is not set
+ * to pdFALSE, so should be initialised to pdFALSE.
+ *
+ * @return See ucEventGroupSetBits().
+ *
+ * Example usage:
+   <pre>
+ #define BIT_4 ( 1 << 4 )
+
+ void vTimeoutISR( void )
+ {
+ signed portCHAR cTaskWoken = ( signed portCHAR ) pdFALSE;
+
+    ucEventGroupSetBitsFromISR( xEventGroup, BIT_4, &cTaskWoken );
+
+    if( cTaskWoken )
+    {
+        taskYIELD();
+    }
+ }
+   </pre>
+ * \defgroup ucEventGroupSetBitsFromISR ucEventGroupSetBitsFromISR
+ * \ingroup EventGroup
+ */
+unsigned portCHAR ucEventGroupSetBitsFromISR( xEventGroupHandle xEventGroup, unsigned portCHAR ucBitsToSet, signed portCHAR *pcTaskWoken );
+
+/**
+ * event_groups. h
+ *<pre>
+ unsigned portCHAR ucEventGroupClearBits( xEventGroupHandle xEventGroup, unsigned portCHAR ucBitsToClear );</pre>
+ *
+ * Clear bits within an event group.  Clearing bits never wakes a task, so 
+ * this function can also be called from an interrupt.
+ *
+ * @param xEventGroup The event group in which the bits are to be cleared.
+ *
+ * @param ucBitsToClear A bitwise value that indicates the bit or bits to 
+ * clear.
+ *
+ * @return The value of the event group before the bits were cleared.
+ *
+ * \defgroup ucEventGroupClearBits ucEventGroupClearBits
+ * \ingroup EventGroup
+ */
+unsigned portCHAR ucEventGroupClearBits( xEventGroupHandle xEventGroup, unsigned portCHAR ucBitsToClear );
+
+/**
+ * event_groups. h
+ *<pre>
+ unsigned portCHAR ucEventGroupGetBits( xEventGroupHandle xEventGroup );</pre>
+ *
+ * Returns the current value of the bits in an event group.  Can be called
+ * from an interrupt.
+ *
+ * \defgroup ucEventGroupGetBits ucEventGroupGetBits
+ * \ingroup EventGroup
+ */
+unsigned portCHAR ucEventGroupGetBits( xEventGroupHandle xEventGroup );
+
+/**
+ * event_groups. h
+ *<pre>
+ void vEventGroupDelete( xEventGroupHandle xEventGroup );</pre>
+ *
+ * Return an event group to the pool of free event groups.  Any task waiting
+ * on the event group is woken, and returns the value 0 from 
+ * ucEventGroupWaitBits().
+ *
+ * \defgroup vEventGroupDelete vEventGroupDelete
+ * \ingroup EventGroup
+ */
+void vEventGroupDelete( xEventGroupHandle xEventGroup );
+
+#endif /* EVENT_GROUPS_H */
+
@@ -68,11 +68,11 @@
  */
 struct xLIST_ITEM
 {
-	portTickType xItemValue;				/*< The value being listed.  In most cases this is used to sort the list in descending order. */
-	volatile struct xLIST_ITEM * pxNext;	/*< Pointer to the next xListItem in the list. */
-	volatile struct xLIST_ITEM * pxPrevious;/*< Pointer to the previous xListItem in the list. */
-	void * pvOwner;							/*< Pointer to the object (normally a TCB) that contains the list item.  There is therefore a two way link between the object containing the list item and the list item itself. */
-	void * pvContainer;						/*< Pointer to the list in which this list item is placed (if any). */
+	portTickType xItemValue;								/*< The value being listed.  In most cases this is used to sort the list in descending order. */
+	volatile struct xLIST_ITEM portOBJECT_SPACE * pxNext;	/*< Pointer to the next xListItem in the list. */
+	volatile struct xLIST_ITEM portOBJECT_SPACE * pxPrevious;	/*< Pointer to the previous xListItem in the list. */
+	void portOBJECT_SPACE * pvOwner;						/*< Pointer to the object (normally a TCB) that contains the list item.  There is therefore a two way link between the object containing the list item and the list item itself. */
+	void portOBJECT_SPACE * pvContainer;					/*< Pointer to the list in which this list item is placed (if any). */
 };
 typedef struct xLIST_ITEM xListItem;		/* For some reason lint wants this as two separate definitions. */
 
@@ -82,9 +82,9 @@ typedef struct xLIST_ITEM xListItem;		/* For some reason lint wants this as two
 typedef struct xLIST
 {
 	unsigned portSHORT usNumberOfItems;
-	volatile xListItem * pxHead;			/*< Pointer to the xListEnd item.  xListEnd contains a wrap back pointer to true list head. */
-	volatile xListItem * pxIndex;			/*< Used to walk through the list.  Points to the last item returned by a call to pvListGetOwnerOfNextEntry(). */
-	volatile xListItem xListEnd;			/*< List item that contains the maximum possible item value meaning it is always at the end of the list and is therefore used as a marker. */
+	volatile xListItem portOBJECT_SPACE * pxHead;			/*< Pointer to the xListEnd item.  xListEnd contains a wrap back pointer to true list head. */
+	volatile xListItem portOBJECT_SPACE * pxIndex;			/*< Used to walk through the list.  Points to the last item returned by a call to pvListGetOwnerOfNextEntry(). */
+	volatile xListItem xListEnd;							/*< List item that contains the maximum possible item value meaning it is always at the end of the list and is therefore used as a marker. */
 } xList;
 
 /*
@@ -95,7 +95,7 @@ typedef struct xLIST
  * \ingroup LinkedList
  * <HR>
  */
-#define listSET_LIST_ITEM_OWNER( pxListItem, pxOwner )		{ ( pxListItem )->pvOwner = ( void * ) pxOwner; }
+#define listSET_LIST_ITEM_OWNER( pxListItem, pxOwner )		{ ( pxListItem )->pvOwner = ( void portOBJECT_SPACE * ) pxOwner; }
 
 /*
  * Access macro to set the value of the list item.  In most cases the value is
@@ -158,7 +158,7 @@ typedef struct xLIST
 	{																					\
 		( pxList )->pxIndex = ( pxList )->pxIndex->pxNext;								\
 	}																					\
-	pxTCB = ( volatile tskTCB * ) ( pxList )->pxIndex->pvOwner;							\
+	pxTCB = ( volatile tskTCB portOBJECT_SPACE * ) ( pxList )->pxIndex->pvOwner;		\
 }
 
 /*
@@ -190,7 +190,7 @@ typedef struct xLIST
  * @return pdTRUE is the list item is in the list, otherwise pdFALSE.
  * pointer against
  */
-#define listIS_CONTAINED_WITHIN( pxList, pxListItem ) ( ( pxListItem )->pvContainer == ( void * ) pxList )
+#define listIS_CONTAINED_WITHIN( pxList, pxListItem ) ( ( pxListItem )->pvContainer == ( void portOBJECT_SPACE * ) pxList )
 
 /*
  * Must be called before a list is used!  This initialises all the members
@@ -203,7 +203,7 @@ typedef struct xLIST
  * \ingroup LinkedList
  * <HR>
  */
-void vListInitialise( xList *pxList );
+void vListInitialise( xList portOBJECT_SPACE *pxList );
 
 /*
  * Must be called before a list item is used.  This sets the list container to
@@ -215,7 +215,7 @@ void vListInitialise( xList *pxList );
  * \ingroup LinkedList
  * <HR>
  */
-void vListInitialiseItem( xListItem *pxItem );
+void vListInitialiseItem( xListItem portOBJECT_SPACE *pxItem );
 
 /*
  * Insert a list item into a list.  The item will be inserted into the list in
@@ -229,7 +229,7 @@ void vListInitialiseItem( xListItem *pxItem );
  * \ingroup LinkedList
  * <HR>
  */
-void vListInsert( xList *pxList, xListItem *pxNewListItem );
+void vListInsert( xList portOBJECT_SPACE *pxList, xListItem portOBJECT_SPACE *pxNewListItem );
 
 /*
  * Insert a list item into a list.  The item will be inserted in a position
@@ -251,7 +251,7 @@ void vListInsert( xList *pxList, xListItem *pxNewListItem );
  * \ingroup LinkedList
  * <HR>
  */
-void vListInsertEnd( xList *pxList, xListItem *pxNewListItem );
+void vListInsertEnd( xList portOBJECT_SPACE *pxList, xListItem portOBJECT_SPACE *pxNewListItem );
 
 /*
  * Remove an item from a list.  The list item has a pointer to the list that
@@ -264,7 +264,7 @@ void vListInsertEnd( xList *pxList, xListItem *pxNewListItem );
  * \ingroup LinkedList
  * <HR>
  */
-void vListRemove( xListItem *pxItemToRemove );
+void vListRemove( xListItem portOBJECT_SPACE *pxItemToRemove );
 
 
 
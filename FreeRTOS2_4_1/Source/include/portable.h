@@ -79,6 +79,38 @@
 	#include "../../Source/portable/GCC/ARM7/portmacro.h"
 #endif
 
+/*
+ * Memory space qualifiers for the kernel variables, for compilers that place
+ * variables in different memory spaces.  portKERNEL_HOT_DATA is used for the
+ * few variables read on every context switch, and portKERNEL_DATA for all the
+ * other kernel variables.  Ports that do not need them leave them undefined.
+ */
+#ifndef portKERNEL_HOT_DATA
+	#define portKERNEL_HOT_DATA
+#endif
+
+#ifndef portKERNEL_DATA
+	#define portKERNEL_DATA
+#endif
+
+/*
+ * Memory space qualifier for the objects referenced by the pointers within 
+ * list items, lists, TCBs and queues.  A port can define this when all such
+ * objects - including task stacks and queue storage - are placed in a single
+ * memory space, so the pointers need not be able to address any other.
+ */
+#ifndef portOBJECT_SPACE
+	#define portOBJECT_SPACE
+#endif
+
+/*
+ * Memory space qualifier for constant tables, for compilers that do not
+ * place const data in code memory by default.
+ */
+#ifndef portCODE_SPACE
+	#define portCODE_SPACE
+#endif
+
 
 /*
  * Setup the stack of a new task so it is ready to be placed under the 
@@ -33,7 +33,7 @@
 #ifndef QUEUE_H
 #define QUEUE_H
 
-typedef void * xQueueHandle;
+typedef void portOBJECT_SPACE * xQueueHandle;
 
 /**
  * queue. h
@@ -453,6 +453,17 @@ signed portCHAR cQueueSendFromISR( xQueueHandle pxQueue, const void *pvItemToQue
  */
 signed portCHAR cQueueReceiveFromISR( xQueueHandle pxQueue, void *pcBuffer, signed portCHAR *pcTaskWoken );
 
+/*
+ * The functions defined below are for passing data to and from co-routines.
+ * They are called by the co-routine macros defined in croutine.h - 
+ * crQUEUE_SEND(), crQUEUE_RECEIVE(), crQUEUE_SEND_FROM_ISR() and 
+ * crQUEUE_RECEIVE_FROM_ISR() - and should not be called directly.
+ */
+signed portCHAR cQueueCRSend( xQueueHandle pxQueue, const void *pvItemToQueue, portTickType xTicksToWait );
+signed portCHAR cQueueCRReceive( xQueueHandle pxQueue, void *pvBuffer, portTickType xTicksToWait );
+signed portCHAR cQueueCRSendFromISR( xQueueHandle pxQueue, const void *pvItemToQueue, signed portCHAR cCoRoutinePreviouslyWoken );
+signed portCHAR cQueueCRReceiveFromISR( xQueueHandle pxQueue, void *pvBuffer, signed portCHAR *pcCoRoutineWoken );
+
 
 #endif
 
@@ -51,7 +51,7 @@
  * \ingroup Tasks
  * <HR>
  */
-typedef void * xTaskHandle;
+typedef void portOBJECT_SPACE * xTaskHandle;
 
 /*
  * Defines the priority used by the idle task.  This must not be modified. 
@@ -70,6 +70,19 @@ typedef void * xTaskHandle;
  */
 #define tskMAX_TASK_NAME_LEN		 ( 16 )
 
+/*
+ * Actions that can be performed on the notification value of a task by
+ * cTaskNotify() and cTaskNotifyFromISR().
+ *
+ * \ingroup TaskNotifications
+ * <HR>
+ */
+#define tskNOTIFY_NO_ACTION							( ( unsigned portCHAR ) 0 )	/*< Notify the task without changing its notification value. */
+#define tskNOTIFY_SET_BITS							( ( unsigned portCHAR ) 1 )	/*< OR ulValue into the notification value. */
+#define tskNOTIFY_INCREMENT							( ( unsigned portCHAR ) 2 )	/*< Increment the notification value - ulValue is not used. */
+#define tskNOTIFY_SET_VALUE_WITH_OVERWRITE			( ( unsigned portCHAR ) 3 )	/*< Set the notification value to ulValue. */
+#define tskNOTIFY_SET_VALUE_WITHOUT_OVERWRITE		( ( unsigned portCHAR ) 4 )	/*< Set the notification value to ulValue unless the task has a notification it has not yet received. */
+
 /**
  * task. h
  *
@@ -204,6 +217,49 @@ typedef void * xTaskHandle;
  */
 portSHORT sTaskCreate( pdTASK_CODE pvTaskCode, const signed portCHAR * const pcName, unsigned portSHORT usStackDepth, void *pvParameters, unsigned portCHAR ucPriority, xTaskHandle *pvCreatedTask );
 
+/**
+ * task. h
+ *<pre>
+ * portSHORT sTaskCreateResident( 
+ *                          pdTASK_CODE pvTaskCode, 
+ *                          const portCHAR * const pcName, 
+ *                          void *pvParameters, 
+ *                          unsigned portCHAR ucPriority, 
+ *                          unsigned portCHAR ucStackSlot, 
+ *                          xTaskHandle *pvCreatedTask 
+ *                      );</pre>
+ *
+ * Only available on ports that define portNUM_STACK_SLOTS to be greater than
+ * zero.
+ *
+ * As sTaskCreate(), but the task uses a stack slot reserved by the port in 
+ * place of a stack allocated from the heap.  The stack of such a task is
+ * never moved, making context switches into and out of the task faster.  The
+ * size of the stack is fixed by the port (portSTACK_SLOT_SIZE).
+ *
+ * Each slot can only be used by one task.
+ *
+ * @param ucStackSlot The slot to use, from 0 to ( portNUM_STACK_SLOTS - 1 ).
+ *
+ * @return pdPASS if the task was successfully created and added to a ready 
+ * list, otherwise an error code defined in the file errors. h
+ *
+ * Example usage:
+   <pre>
+ // Function that creates a latency critical task.
+ void vOtherFunction( void )
+ {
+     // Create the task in the first stack slot.
+     sTaskCreateResident( vTaskCode, "FAST", NULL, tskIDLE_PRIORITY + 3, 0, NULL );
+ }
+   </pre>
+ * \defgroup sTaskCreateResident sTaskCreateResident
+ * \ingroup Tasks
+ */
+#if( portNUM_STACK_SLOTS > 0 )
+	portSHORT sTaskCreateResident( pdTASK_CODE pvTaskCode, const signed portCHAR * const pcName, void *pvParameters, unsigned portCHAR ucPriority, unsigned portCHAR ucStackSlot, xTaskHandle *pvCreatedTask );
+#endif
+
 /**
  * task. h
  * <pre>void vTaskDelete( xTaskHandle pxTask );</pre>
@@ -296,6 +352,117 @@ void vTaskDelete( xTaskHandle pxTask );
  */
 void vTaskDelay( portTickType xTicksToDelay );
 
+/**
+ * task. h
+ * <pre>signed portCHAR cTaskDelayUntil( portTickType *pxPreviousWakeTime, portTickType xTimeIncrement );</pre>
+ *
+ * INCLUDE_cTaskDelayUntil must be defined as 1 for this function to be available.
+ * See the configuration section for more information.
+ *
+ * Delay a task until a specified time.  This function can be used by cyclical
+ * tasks to ensure a constant execution frequency.
+ *
+ * This function differs from vTaskDelay() in one important aspect:  vTaskDelay()
+ * specifies a time at which the task wishes to unblock relative to the time 
+ * at which vTaskDelay() is called, whereas cTaskDelayUntil() specifies an 
+ * absolute time at which the task wishes to unblock.
+ *
+ * vTaskDelay() will cause a task to block for the specified number of ticks
+ * from the time vTaskDelay() is called.  It is therefore difficult to use
+ * vTaskDelay() by itself to generate a fixed execution frequency as the time 
+ * between a task unblocking following a call to vTaskDelay() and that task
+ * next calling vTaskDelay() may not be fixed [the task may take a different
+ * path though the code between calls, or may get interrupted or preempted a 
+ * different number of times each time it executes].
+ *
+ * Whereas vTaskDelay() specifies a wake time relative to the time at which
+ * the function is called, cTaskDelayUntil() specifies the absolute (exact) 
+ * time at which it wishes to unblock.
+ *
+ * The constant portTICKS_PER_MS can be used to calculate real time from 
+ * the tick rate - with the resolution of one tick period.
+ *
+ * @param pxPreviousWakeTime Pointer to a variable that holds the time at 
+ * which the task was last unblocked.  The variable must be initialised with 
+ * the current time prior to its first use (see the example below).  Following
+ * this the variable is automatically updated within cTaskDelayUntil().
+ *
+ * @param xTimeIncrement The cycle time period.  The task will be unblocked at
+ * time *pxPreviousWakeTime + xTimeIncrement.  Calling cTaskDelayUntil with the 
+ * same xTimeIncrement parameter value will cause the task to execute with 
+ * a fixed execution period.
+ *
+ * @return pdTRUE if the task was blocked, or if the wake time is the current
+ * tick so the release is exactly on time.  pdFALSE if the wake time had 
+ * already passed, in which case the task continues without blocking.  
+ * *pxPreviousWakeTime is advanced by xTimeIncrement in either case, so a 
+ * release that has been missed does not shift the releases that follow.
+ *
+ * Example usage:
+   <pre>
+ // Perform an action every 10 ticks.
+ void vTaskFunction( void * pvParameters )
+ {
+ portTickType xLastWakeTime;
+ const portTickType xFrequency = 10;
+
+     // Initialise the xLastWakeTime variable with the current time.
+     xLastWakeTime = xTaskGetTickCount ();
+     for( ;; )
+     {
+         // Wait for the next cycle.
+         if( cTaskDelayUntil( &xLastWakeTime, xFrequency ) != pdTRUE )
+         {
+             // The previous cycle overran into this one.
+         }
+
+         // Perform action here.
+     }
+ }
+   </pre>
+ * \defgroup cTaskDelayUntil cTaskDelayUntil
+ * \ingroup TaskCtrl
+ */
+signed portCHAR cTaskDelayUntil( portTickType *pxPreviousWakeTime, portTickType xTimeIncrement );
+
+/**
+ * task. h
+ * <pre>void vTaskDelayLong( unsigned portLONG ulTicksToDelay );</pre>
+ *
+ * USE_TICK_EPOCH must be defined as 1 for this function to be available.
+ * See the configuration section for more information.
+ *
+ * Delay a task for a number of ticks that may be greater than portMAX_DELAY.
+ * The delay is measured using the tick count extended by the number of times
+ * it has wrapped (see ulTaskGetExtendedTickCount()), so tasks can be delayed 
+ * for minutes or hours while the kernel continues to use 16 bit tick values.
+ *
+ * The task waits for the tick epoch in which it is to wake, then completes 
+ * the remainder of the delay as vTaskDelay() would.
+ *
+ * @param ulTicksToDelay The amount of time, in tick periods, that
+ * the calling task should block.
+ *
+ * Example usage:
+   <pre>
+ // Perform an action once an hour.
+ void vTaskFunction( void * pvParameters )
+ {
+ const unsigned portLONG ulOneHour = ( unsigned portLONG ) 3600000 / portTICKS_PER_MS;
+
+     for( ;; )
+     {
+         vTaskDelayLong( ulOneHour );
+
+         // Perform action here.
+     }
+ }
+   </pre>
+ * \defgroup vTaskDelayLong vTaskDelayLong
+ * \ingroup TaskCtrl
+ */
+void vTaskDelayLong( unsigned portLONG ulTicksToDelay );
+
 /**
  * task. h
  * <pre>unsigned portCHAR ucTaskPriorityGet( xTaskHandle pxTask );</pre>
@@ -700,6 +867,21 @@ signed portCHAR cTaskResumeAll( void );
  */
 volatile portTickType xTaskGetTickCount( void );
 
+/**
+ * task. h
+ * <PRE>unsigned portLONG ulTaskGetExtendedTickCount( void );</PRE>
+ *
+ * USE_TICK_EPOCH must be defined as 1 for this function to be available.
+ *
+ * @return The count of ticks since vTaskStartScheduler was called, with the
+ * number of times the 16 bit tick count has wrapped in the upper 16 bits.
+ *
+ * \page ulTaskGetExtendedTickCount ulTaskGetExtendedTickCount
+ * \ingroup TaskUtils
+ * <HR>
+ */
+unsigned portLONG ulTaskGetExtendedTickCount( void );
+
 /**
  * task. h
  * <PRE>unsigned portSHORT usTaskGetNumberOfTasks( void );</PRE>
@@ -779,6 +961,239 @@ void vTaskStartTrace( signed portCHAR * pcBuffer, unsigned portSHORT usBufferSiz
  */
 unsigned portSHORT usTaskEndTrace( void );
 
+/**
+ * task. h
+ * <PRE>void vTaskGetStackUsage( xTaskHandle pxTask, unsigned portSHORT *pusMaxStackBytes, unsigned portSHORT *pusFreeStackSpace );</PRE>
+ *
+ * USE_TRACE_FACILITY must be defined as 1 for this function to be available.
+ * See the configuration section for more information.
+ *
+ * Reports two measures of the stack usage of a task.  The first is recorded
+ * by the port each time the task is switched out, so includes the context 
+ * saved by the switch but not any deeper use between switches.  The second 
+ * is found by scanning the stack for bytes that have never been written, so
+ * covers all use - but is only available for a task that was given a stack
+ * from the heap when it was created.  Together they show how far the stack 
+ * depth passed to sTaskCreate () can be reduced.
+ *
+ * @param pxTask The handle of the task being queried.  Passing NULL queries
+ * the calling task, whose depth is that recorded when it was last switched 
+ * out.
+ *
+ * @param pusMaxStackBytes Set to the deepest stack, in bytes, the task has 
+ * had when switched out.
+ *
+ * @param pusFreeStackSpace Set to the number of bytes at the end of the 
+ * stack that have never been used, or zero if the task has a resident stack 
+ * slot.
+ *
+ * \page vTaskGetStackUsage vTaskGetStackUsage
+ * \ingroup TaskUtils
+ * <HR>
+ */
+void vTaskGetStackUsage( xTaskHandle pxTask, unsigned portSHORT *pusMaxStackBytes, unsigned portSHORT *pusFreeStackSpace );
+
+/*-----------------------------------------------------------
+ * TASK NOTIFICATION API
+ *----------------------------------------------------------*/
+
+/**
+ * task. h
+ * <PRE>signed portCHAR cTaskNotify( xTaskHandle pxTaskToNotify, unsigned portLONG ulValue, unsigned portCHAR ucAction );</PRE>
+ *
+ * USE_TASK_NOTIFICATIONS must be defined as 1 for this function to be 
+ * available.
+ *
+ * Each task has a 32 bit notification value that other tasks and interrupts
+ * can update, and that the task can wait on with cTaskNotifyWait() or 
+ * ulTaskNotifyTake().  A notification is sent directly to the task, so no 
+ * queue or semaphore has to be created, and a task waiting for a 
+ * notification is made ready without going through an event list.  A 
+ * notification can therefore often be used in place of a binary semaphore,
+ * a counting semaphore or a queue of length one - but it can only have a 
+ * single receiving task.
+ *
+ * @param pxTaskToNotify The handle of the task being notified.
+ *
+ * @param ulValue Used to update the notification value, depending on 
+ * ucAction.
+ *
+ * @param ucAction One of:
+ *
+ * tskNOTIFY_NO_ACTION - the notification value is not changed.
+ *
+ * tskNOTIFY_SET_BITS - the notification value is bitwise ORed with ulValue.
+ *
+ * tskNOTIFY_INCREMENT - the notification value is incremented.
+ *
+ * tskNOTIFY_SET_VALUE_WITH_OVERWRITE - the notification value is set to 
+ * ulValue, whether or not the task had received the previous notification.
+ *
+ * tskNOTIFY_SET_VALUE_WITHOUT_OVERWRITE - the notification value is set to 
+ * ulValue only if the task had received the previous notification.
+ *
+ * @return pdFAIL if ucAction is tskNOTIFY_SET_VALUE_WITHOUT_OVERWRITE and
+ * the value was not updated, otherwise pdPASS.
+ *
+ * Example usage:
+   <pre>
+ void vTxTask( void * pvParameters )
+ {
+ extern xTaskHandle xRxTask;
+
+     for( ;; )
+     {
+         // Tell the receiving task that event 0x01 has occurred.
+         cTaskNotify( xRxTask, 0x01, tskNOTIFY_SET_BITS );
+         vTaskDelay( 100 );
+     }
+ }
+   </pre>
+ * \page cTaskNotify cTaskNotify
+ * \ingroup TaskNotifications
+ * <HR>
+ */
+signed portCHAR cTaskNotify( xTaskHandle pxTaskToNotify, unsigned portLONG ulValue, unsigned portCHAR ucAction );
+
+/**
+ * task. h
+ * <PRE>signed portCHAR cTaskNotifyFromISR( xTaskHandle pxTaskToNotify, unsigned portLONG ulValue, unsigned portCHAR ucAction, signed portCHAR *pcTaskWoken );</PRE>
+ *
+ * A version of cTaskNotify() that can be called from an ISR.
+ *
+ * @param pxTaskToNotify The handle of the task being notified.
+ *
+ * @param ulValue See cTaskNotify().
+ *
+ * @param ucAction See cTaskNotify().
+ *
+ * @param pcTaskWoken Set to pdTRUE if notifying the task caused it to leave
+ * the Blocked state, and it has a priority higher than the task that was 
+ * interrupted.  It is not set to pdFALSE, so should be initialised to 
+ * pdFALSE before the first call made by the ISR.
+ *
+ * @return See cTaskNotify().
+ *
+ * Example usage:
+   <pre>
+ void vRxISR( void )
+ {
+ signed portCHAR cTaskWoken = ( signed portCHAR ) pdFALSE;
+
+     // Unblock the task that processes the received data.
+     vTaskNotifyGiveFromISR( xRxTask, &cTaskWoken );
+
+     if( cTaskWoken )
+     {
+         taskYIELD();
+     }
+ }
+   </pre>
+ * \page cTaskNotifyFromISR cTaskNotifyFromISR
+ * \ingroup TaskNotifications
+ * <HR>
+ */
+signed portCHAR cTaskNotifyFromISR( xTaskHandle pxTaskToNotify, unsigned portLONG ulValue, unsigned portCHAR ucAction, signed portCHAR *pcTaskWoken );
+
+/**
+ * task. h
+ * <PRE>signed portCHAR cTaskNotifyWait( unsigned portLONG ulBitsToClearOnEntry, unsigned portLONG ulBitsToClearOnExit, unsigned portLONG *pulNotificationValue, portTickType xTicksToWait );</PRE>
+ *
+ * Wait, with a timeout, for the calling task to receive a notification.
+ * Returns immediately if a notification was sent since the task last 
+ * received one.
+ *
+ * @param ulBitsToClearOnEntry Bits that are cleared in the notification 
+ * value if the task has no notification pending when it calls the function.
+ *
+ * @param ulBitsToClearOnExit Bits that are cleared in the notification 
+ * value when a notification is received, after the value has been copied
+ * to *pulNotificationValue.
+ *
+ * @param pulNotificationValue Receives the notification value before any 
+ * bits are cleared on exit.  Can be NULL if the value is not required.
+ *
+ * @param xTicksToWait The maximum number of ticks to wait for a notification.
+ * A value of 0 just tests for a pending notification.
+ *
+ * @return pdTRUE if a notification was received, otherwise pdFALSE.
+ *
+ * Example usage:
+   <pre>
+ void vRxTask( void * pvParameters )
+ {
+ unsigned portLONG ulEvents;
+
+     for( ;; )
+     {
+         // Wait up to 500 ticks for any event bits, clearing them all once
+         // they have been read.
+         if( cTaskNotifyWait( 0, 0xffffffffUL, &ulEvents, 500 ) )
+         {
+             if( ulEvents & 0x01 )
+             {
+                 // Process event 0x01.
+             }
+         }
+     }
+ }
+   </pre>
+ * \page cTaskNotifyWait cTaskNotifyWait
+ * \ingroup TaskNotifications
+ * <HR>
+ */
+signed portCHAR cTaskNotifyWait( unsigned portLONG ulBitsToClearOnEntry, unsigned portLONG ulBitsToClearOnExit, unsigned portLONG *pulNotificationValue, portTickType xTicksToWait );
+
+/**
+ * task. h
+ * <PRE>unsigned portLONG ulTaskNotifyTake( signed portCHAR cClearCountOnExit, portTickType xTicksToWait );</PRE>
+ *
+ * Use the notification value as a counting (or binary) semaphore, given by
+ * cTaskNotifyGive() or vTaskNotifyGiveFromISR().  Waits, with a timeout, for
+ * the notification value to be non-zero.
+ *
+ * @param cClearCountOnExit If pdTRUE the notification value is cleared to
+ * zero on exit, so it behaves as a binary semaphore.  Otherwise it is
+ * decremented, so it behaves as a counting semaphore.
+ *
+ * @param xTicksToWait The maximum number of ticks to wait for the value to
+ * become non-zero.
+ *
+ * @return The notification value before it was cleared or decremented, so
+ * zero if the wait timed out.
+ *
+ * \page ulTaskNotifyTake ulTaskNotifyTake
+ * \ingroup TaskNotifications
+ * <HR>
+ */
+unsigned portLONG ulTaskNotifyTake( signed portCHAR cClearCountOnExit, portTickType xTicksToWait );
+
+/**
+ * task. h
+ * <PRE>signed portCHAR cTaskNotifyGive( xTaskHandle pxTaskToNotify );</PRE>
+ *
+ * Increment the notification value of a task, for use with 
+ * ulTaskNotifyTake().
+ *
+ * \page cTaskNotifyGive cTaskNotifyGive
+ * \ingroup TaskNotifications
+ * <HR>
+ */
+#define cTaskNotifyGive( pxTaskToNotify ) cTaskNotify( ( pxTaskToNotify ), ( unsigned portLONG ) 0, tskNOTIFY_INCREMENT )
+
+/**
+ * task. h
+ * <PRE>void vTaskNotifyGiveFromISR( xTaskHandle pxTaskToNotify, signed portCHAR *pcTaskWoken );</PRE>
+ *
+ * A version of cTaskNotifyGive() that can be called from an ISR.  See 
+ * cTaskNotifyFromISR() for the use of pcTaskWoken.
+ *
+ * \page vTaskNotifyGiveFromISR vTaskNotifyGiveFromISR
+ * \ingroup TaskNotifications
+ * <HR>
+ */
+#define vTaskNotifyGiveFromISR( pxTaskToNotify, pcTaskWoken ) ( void ) cTaskNotifyFromISR( ( pxTaskToNotify ), ( unsigned portLONG ) 0, tskNOTIFY_INCREMENT, ( pcTaskWoken ) )
+
 
 /*-----------------------------------------------------------
  * SCHEDULER INTERNALS AVAILABLE FOR PORTING PURPOSES
@@ -796,6 +1211,34 @@ unsigned portSHORT usTaskEndTrace( void );
  */
 inline void vTaskIncrementTick( void );
 
+#if( portUSE_TICKLESS_IDLE == 1 )
+
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN
+ * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * THIS FUNCTION MUST BE CALLED WITH INTERRUPTS DISABLED.
+ *
+ * Returns the number of ticks before any task other than the idle task can
+ * run, or zero if one might already be able to.  Used by the port to decide
+ * how long the tick can be suppressed for.
+ */
+portTickType xTaskGetExpectedIdleTime( void );
+
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN
+ * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * THIS FUNCTION MUST BE CALLED WITH INTERRUPTS DISABLED AND THE SCHEDULER
+ * SUSPENDED.
+ *
+ * Corrects the tick count after the tick has been suppressed.  xTicksToJump
+ * must be less than the value last returned by xTaskGetExpectedIdleTime().
+ */
+void vTaskStepTick( portTickType xTicksToJump );
+
+#endif
+
 /*
  * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN 
  * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
@@ -817,7 +1260,7 @@ inline void vTaskIncrementTick( void );
  * portTICKS_PER_MS can be used to convert kernel ticks into a real time
  * period.
  */
-void vTaskPlaceOnEventList( xList *pxEventList, portTickType xTicksToWait );
+void vTaskPlaceOnEventList( xList portOBJECT_SPACE *pxEventList, portTickType xTicksToWait );
 
 /*
  * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN 
@@ -834,7 +1277,40 @@ void vTaskPlaceOnEventList( xList *pxEventList, portTickType xTicksToWait );
  * @return pdTRUE if the task being removed has a higher priority than the task
  * making the call, otherwise pdFALSE.
  */
-signed portCHAR cTaskRemoveFromEventList( const xList *pxEventList );
+signed portCHAR cTaskRemoveFromEventList( const xList portOBJECT_SPACE *pxEventList );
+
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN 
+ * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * THIS FUNCTION MUST BE CALLED WITH INTERRUPTS DISABLED.
+ *
+ * Used by the event groups.  As vTaskPlaceOnEventList(), except the event 
+ * list item of the task is given the value xItemValue and placed at the end 
+ * of the event list, rather than in priority order.
+ */
+void vTaskPlaceOnUnorderedEventList( xList portOBJECT_SPACE *pxEventList, portTickType xItemValue, portTickType xTicksToWait );
+
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN 
+ * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * THIS FUNCTION MUST BE CALLED WITH INTERRUPTS DISABLED.
+ *
+ * Used by the event groups.  As cTaskRemoveFromEventList(), except the task
+ * removed is the owner of pxEventListItem, which is first given the value
+ * xItemValue for the task to read with xTaskResetEventItemValue().
+ */
+signed portCHAR cTaskRemoveFromUnorderedEventList( xListItem portOBJECT_SPACE *pxEventListItem, portTickType xItemValue );
+
+/*
+ * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN 
+ * INTERFACE WHICH IS FOR THE EXCLUSIVE USE OF THE SCHEDULER.
+ *
+ * Returns the value of the event list item of the calling task, and 
+ * restores the priority order value used by the other event lists.
+ */
+portTickType xTaskResetEventItemValue( void );
 
 /*
  * THIS FUNCTION MUST NOT BE USED FROM APPLICATION CODE.  IT IS AN 
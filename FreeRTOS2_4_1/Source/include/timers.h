@@ -0,0 +1,297 @@
+/*
+	FreeRTOS V2.4.1 - Copyright (C) 2003, 2004 Richard Barry.
+
+	This file is part of the FreeRTOS distribution.
+
+	FreeRTOS is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	FreeRTOS is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with FreeRTOS; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+	A special exception to the GPL can be applied should you wish to distribute
+	a combined work that includes FreeRTOS, without being obliged to provide
+	the source code for any proprietary components.  See the licensing section 
+	of http://www.FreeRTOS.org for full details of how and when the exception
+	can be applied.
+
+	***************************************************************************
+	See http://www.FreeRTOS.org for documentation, latest information, license 
+	and contact details.  Please ensure to read the configuration and relevant 
+	port sections of the online documentation.
+	***************************************************************************
+*/
+
+#ifndef TIMERS_H
+#define TIMERS_H
+
+/*-----------------------------------------------------------
+ * MACROS AND DEFINITIONS
+ *----------------------------------------------------------*/
+
+/**
+ * timers. h
+ *
+ * Type by which software timers are referenced.  xTimerCreate() returns an
+ * xTimerHandle that can then be passed to the other timer API functions.
+ *
+ * \page xTimerHandle xTimerHandle
+ * \ingroup Timers
+ * <HR>
+ */
+typedef void portOBJECT_SPACE * xTimerHandle;
+
+/*
+ * Type of the function called when a timer expires.  The handle of the timer
+ * that expired is passed in, so one function can serve several timers - 
+ * pvTimerGetTimerID() can be used to tell them apart.
+ */
+typedef void (*tmrTIMER_CALLBACK)( xTimerHandle xTimer );
+
+/* The commands sent to the timer task.  Used by the macros below. */
+#define tmrCOMMAND_START			( ( signed portCHAR ) 0 )
+#define tmrCOMMAND_STOP				( ( signed portCHAR ) 1 )
+#define tmrCOMMAND_CHANGE_PERIOD	( ( signed portCHAR ) 2 )
+#define tmrCOMMAND_DELETE			( ( signed portCHAR ) 3 )
+
+/*-----------------------------------------------------------
+ * TIMER CREATION API
+ *----------------------------------------------------------*/
+
+/**
+ * timers. h
+ *<pre>
+ xTimerHandle xTimerCreate( 
+                              portTickType xTimerPeriod, 
+                              unsigned portCHAR ucAutoReload, 
+                              void *pvTimerID, 
+                              tmrTIMER_CALLBACK pxCallbackFunction 
+                          );</pre>
+ *
+ * Create a new software timer.  The timer is created in the dormant state - 
+ * cTimerStart() or cTimerReset() must be used to start it.
+ *
+ * Timers do not each need a task.  A single timer task, created when the 
+ * scheduler is started, keeps the active timers in a list sorted by expiry time 
+ * and calls the callback function of each as it expires.  The timer API 
+ * functions send commands to the timer task on a queue.
+ *
+ * Callback functions execute in the context of the timer task so must never
+ * block, and should be kept short as no other timer can expire while one is
+ * executing.  The priority, stack size and command queue length of the timer
+ * task are set by portTIMER_TASK_PRIORITY, portTIMER_TASK_STACK_SIZE and 
+ * portTIMER_QUEUE_LENGTH.
+ *
+ * @param xTimerPeriod The period of the timer in ticks.  The constant 
+ * portTICKS_PER_MS can be used to convert from a time in milliseconds.  Must
+ * be greater than 0.
+ *
+ * @param ucAutoReload pdTRUE for a timer that restarts itself each time it 
+ * expires, so its callback is called every xTimerPeriod ticks.  pdFALSE for a
+ * one shot timer that becomes dormant once it has expired.
+ *
+ * @param pvTimerID Any value, made available to the callback function by
+ * pvTimerGetTimerID().
+ *
+ * @param pxCallbackFunction The function to call when the timer expires.
+ *
+ * @return A handle to the new timer, or NULL if either the timer or, when 
+ * creating the first timer, the timer command queue could not be allocated.
+ *
+ * Example usage:
+   <pre>
+ // Toggles the LED whose number was used as the timer ID.
+ void vFlashCallback( xTimerHandle xTimer )
+ {
+    vParTestToggleLED( ( unsigned portCHAR ) pvTimerGetTimerID( xTimer ) );
+ }
+
+ void vStartFlashTimer( void )
+ {
+ xTimerHandle xTimer;
+
+    // Flash LED 3 every 250ms.
+    xTimer = xTimerCreate( 250 / portTICKS_PER_MS, pdTRUE, ( void * ) 3, vFlashCallback );
+    if( xTimer != NULL )
+    {
+        // The scheduler has not been started so do not block.
+        cTimerStart( xTimer, 0 );
+    }
+ }
+   </pre>
+ * \defgroup xTimerCreate xTimerCreate
+ * \ingroup Timers
+ */
+xTimerHandle xTimerCreate( portTickType xTimerPeriod, unsigned portCHAR ucAutoReload, void *pvTimerID, tmrTIMER_CALLBACK pxCallbackFunction );
+
+/**
+ * timers. h
+ * <pre>void *pvTimerGetTimerID( xTimerHandle xTimer );</pre>
+ *
+ * @return The pvTimerID value passed to xTimerCreate() when the timer was
+ * created.
+ *
+ * \defgroup pvTimerGetTimerID pvTimerGetTimerID
+ * \ingroup Timers
+ */
+void *pvTimerGetTimerID( xTimerHandle xTimer );
+
+/**
+ * timers. h
+ * <pre>signed portCHAR cTimerIsTimerActive( xTimerHandle xTimer );</pre>
+ *
+ * @return pdTRUE if the timer is running, or pdFALSE if it is dormant.  The
+ * timer task processes commands in the order they are sent, so a timer that
+ * has just been started or stopped only changes state once the timer task 
+ * has run.
+ *
+ * \defgroup cTimerIsTimerActive cTimerIsTimerActive
+ * \ingroup Timers
+ */
+signed portCHAR cTimerIsTimerActive( xTimerHandle xTimer );
+
+/*-----------------------------------------------------------
+ * TIMER CONTROL API
+ *----------------------------------------------------------*/
+
+/**
+ * timers. h
+ * <pre>signed portCHAR cTimerStart( xTimerHandle xTimer, portTickType xBlockTime );</pre>
+ *
+ * <i>Macro</i> that starts a timer.  The timer expires xTimerPeriod ticks 
+ * after the call, however long the command takes to reach the timer task.
+ * Starting a timer that is already running restarts it from the time of the
+ * call, so cTimerReset() does the same.
+ *
+ * @param xTimer The timer to start.
+ *
+ * @param xBlockTime The number of ticks to wait for space on the timer 
+ * command queue should it be full.  Must be 0 if called before the scheduler
+ * has been started or from a timer callback function.
+ *
+ * @return pdPASS if the command was queued, otherwise pdFAIL.
+ *
+ * \defgroup cTimerStart cTimerStart
+ * \ingroup Timers
+ */
+#define cTimerStart( xTimer, xBlockTime )	cTimerGenericCommand( ( xTimer ), tmrCOMMAND_START, xTaskGetTickCount(), ( xBlockTime ) )
+
+/**
+ * timers. h
+ * <pre>signed portCHAR cTimerReset( xTimerHandle xTimer, portTickType xBlockTime );</pre>
+ *
+ * <i>Macro</i> that restarts a timer so it next expires xTimerPeriod ticks 
+ * after the call - see cTimerStart().  A watchdog style timeout can be 
+ * implemented by resetting a one shot timer each time there is activity.
+ *
+ * \defgroup cTimerReset cTimerReset
+ * \ingroup Timers
+ */
+#define cTimerReset( xTimer, xBlockTime )	cTimerStart( ( xTimer ), ( xBlockTime ) )
+
+/**
+ * timers. h
+ * <pre>signed portCHAR cTimerStop( xTimerHandle xTimer, portTickType xBlockTime );</pre>
+ *
+ * <i>Macro</i> that stops a timer, returning it to the dormant state.  See 
+ * cTimerStart() for the parameters and return value.
+ *
+ * \defgroup cTimerStop cTimerStop
+ * \ingroup Timers
+ */
+#define cTimerStop( xTimer, xBlockTime )	cTimerGenericCommand( ( xTimer ), tmrCOMMAND_STOP, ( portTickType ) 0, ( xBlockTime ) )
+
+/**
+ * timers. h
+ * <pre>signed portCHAR cTimerChangePeriod( xTimerHandle xTimer, portTickType xNewPeriod, portTickType xBlockTime );</pre>
+ *
+ * <i>Macro</i> that changes the period of a timer.  The timer is started if
+ * it was dormant, and expires xNewPeriod ticks after the command is 
+ * processed by the timer task.  xNewPeriod must be greater than 0.  See 
+ * cTimerStart() for the other parameters and return value.
+ *
+ * \defgroup cTimerChangePeriod cTimerChangePeriod
+ * \ingroup Timers
+ */
+#define cTimerChangePeriod( xTimer, xNewPeriod, xBlockTime )	cTimerGenericCommand( ( xTimer ), tmrCOMMAND_CHANGE_PERIOD, ( xNewPeriod ), ( xBlockTime ) )
+
+/**
+ * timers. h
+ * <pre>signed portCHAR cTimerDelete( xTimerHandle xTimer, portTickType xBlockTime );</pre>
+ *
+ * <i>Macro</i> that stops a timer and frees its memory.  The handle must not
+ * be used again once the command has been queued.  See cTimerStart() for the
+ * parameters and return value.
+ *
+ * The memory is returned by calling vPortFree().  The block allocation scheme
+ * in portheap.c for the Cygnal port never frees memory, so each timer deleted
+ * when using that scheme leaks its block.  Timers should then be created once
+ * and stopped rather than deleted.
+ *
+ * \defgroup cTimerDelete cTimerDelete
+ * \ingroup Timers
+ */
+#define cTimerDelete( xTimer, xBlockTime )	cTimerGenericCommand( ( xTimer ), tmrCOMMAND_DELETE, ( portTickType ) 0, ( xBlockTime ) )
+
+/**
+ * timers. h
+ * <pre>
+ signed portCHAR cTimerStartFromISR( xTimerHandle xTimer, signed portCHAR cTaskPreviouslyWoken );
+ signed portCHAR cTimerResetFromISR( xTimerHandle xTimer, signed portCHAR cTaskPreviouslyWoken );
+ signed portCHAR cTimerStopFromISR( xTimerHandle xTimer, signed portCHAR cTaskPreviouslyWoken );
+ signed portCHAR cTimerChangePeriodFromISR( xTimerHandle xTimer, portTickType xNewPeriod, signed portCHAR cTaskPreviouslyWoken );</pre>
+ *
+ * <i>Macros</i> that can be used from an interrupt service routine in place
+ * of cTimerStart(), cTimerReset(), cTimerStop() and cTimerChangePeriod().  
+ * The command is not sent if the timer command queue is full.
+ *
+ * @param cTaskPreviouslyWoken Used in the same way as the parameter of the 
+ * same name to cQueueSendFromISR().  The first call within an ISR should pass
+ * in pdFALSE, and subsequent calls the value returned by the previous call.
+ *
+ * @return pdTRUE if sending the command woke the timer task, in which case a
+ * context switch should be requested before the ISR exits.
+ *
+ * Example usage:
+   <pre>
+ // A key press restarts a one shot timer that turns the backlight off when
+ // it expires.
+ void vKeyPressISR( void )
+ {
+ signed portCHAR cTaskWoken;
+
+    vBacklightOn();
+    cTaskWoken = cTimerResetFromISR( xBacklightTimer, pdFALSE );
+    portYIELD_FROM_ISR( cTaskWoken );
+ }
+   </pre>
+ * \defgroup cTimerStartFromISR cTimerStartFromISR
+ * \ingroup Timers
+ */
+#define cTimerStartFromISR( xTimer, cTaskPreviouslyWoken )	cTimerGenericCommandFromISR( ( xTimer ), tmrCOMMAND_START, xTaskGetTickCount(), ( cTaskPreviouslyWoken ) )
+#define cTimerResetFromISR( xTimer, cTaskPreviouslyWoken )	cTimerStartFromISR( ( xTimer ), ( cTaskPreviouslyWoken ) )
+#define cTimerStopFromISR( xTimer, cTaskPreviouslyWoken )	cTimerGenericCommandFromISR( ( xTimer ), tmrCOMMAND_STOP, ( portTickType ) 0, ( cTaskPreviouslyWoken ) )
+#define cTimerChangePeriodFromISR( xTimer, xNewPeriod, cTaskPreviouslyWoken )	cTimerGenericCommandFromISR( ( xTimer ), tmrCOMMAND_CHANGE_PERIOD, ( xNewPeriod ), ( cTaskPreviouslyWoken ) )
+
+/*
+ * Creates the timer task.  Called by vTaskStartScheduler() - not intended to 
+ * be called directly.
+ */
+portSHORT sTimerCreateTimerTask( void );
+
+/*
+ * Functions used by the macros above.  Not intended to be called directly.
+ */
+signed portCHAR cTimerGenericCommand( xTimerHandle xTimer, signed portCHAR cCommandID, portTickType xCommandValue, portTickType xBlockTime );
+signed portCHAR cTimerGenericCommandFromISR( xTimerHandle xTimer, signed portCHAR cCommandID, portTickType xCommandValue, signed portCHAR cTaskPreviouslyWoken );
+
+#endif /* TIMERS_H */
+
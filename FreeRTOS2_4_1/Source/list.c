@@ -62,7 +62,7 @@ Changes from V2.0.0
  * PUBLIC LIST API documented in list.h
  *----------------------------------------------------------*/
 
-void vListInitialise( xList *pxList )
+void vListInitialise( xList portOBJECT_SPACE *pxList )
 {
 	/* The list structure contains a list item which is used to mark the 
 	end of the list.  To initialise the list the list end is inserted
@@ -83,22 +83,22 @@ void vListInitialise( xList *pxList )
 	pxList->xListEnd.pvOwner = NULL;
 
 	/* Make sure the marker items are not mistaken for being on a list. */
-	vListInitialiseItem( ( xListItem * ) &( pxList->xListEnd ) );
+	vListInitialiseItem( ( xListItem portOBJECT_SPACE * ) &( pxList->xListEnd ) );
 
 	pxList->usNumberOfItems = ( unsigned portSHORT ) 0;
 }
 /*-----------------------------------------------------------*/
 
-void vListInitialiseItem( xListItem *pxItem )
+void vListInitialiseItem( xListItem portOBJECT_SPACE *pxItem )
 {
 	/* Make sure the list item is not recorded as being on a list. */
 	pxItem->pvContainer = NULL;
 }
 /*-----------------------------------------------------------*/
 
-void vListInsertEnd( xList *pxList, xListItem *pxNewListItem )
+void vListInsertEnd( xList portOBJECT_SPACE *pxList, xListItem portOBJECT_SPACE *pxNewListItem )
 {
-volatile xListItem * pxIndex;
+volatile xListItem portOBJECT_SPACE * pxIndex;
 
 	/* Insert a new list item into pxList, but rather than sort the list, 
 	makes the new list item the last item to be removed by a call to 
@@ -108,20 +108,20 @@ volatile xListItem * pxIndex;
 
 	pxNewListItem->pxNext = pxIndex->pxNext;
 	pxNewListItem->pxPrevious = pxList->pxIndex;
-	pxIndex->pxNext->pxPrevious = ( volatile xListItem * ) pxNewListItem;
-	pxIndex->pxNext = ( volatile xListItem * ) pxNewListItem;
-	pxList->pxIndex = ( volatile xListItem * ) pxNewListItem;
+	pxIndex->pxNext->pxPrevious = ( volatile xListItem portOBJECT_SPACE * ) pxNewListItem;
+	pxIndex->pxNext = ( volatile xListItem portOBJECT_SPACE * ) pxNewListItem;
+	pxList->pxIndex = ( volatile xListItem portOBJECT_SPACE * ) pxNewListItem;
 
 	/* Remember which list the item is in. */
-	pxNewListItem->pvContainer = ( void * ) pxList;
+	pxNewListItem->pvContainer = ( void portOBJECT_SPACE * ) pxList;
 
 	( pxList->usNumberOfItems )++;
 }
 /*-----------------------------------------------------------*/
 
-void vListInsert( xList *pxList, xListItem *pxNewListItem )
+void vListInsert( xList portOBJECT_SPACE *pxList, xListItem portOBJECT_SPACE *pxNewListItem )
 {
-volatile xListItem *pxIterator;
+volatile xListItem portOBJECT_SPACE *pxIterator;
 register portTickType xValueOfInsertion;
 
 	/* Insert the new list item into the list, sorted in ulListItem order. */
@@ -152,28 +152,28 @@ register portTickType xValueOfInsertion;
 	}
 
 	pxNewListItem->pxNext = pxIterator->pxNext;
-	pxNewListItem->pxNext->pxPrevious = ( volatile xListItem * ) pxNewListItem;
+	pxNewListItem->pxNext->pxPrevious = ( volatile xListItem portOBJECT_SPACE * ) pxNewListItem;
 	pxNewListItem->pxPrevious = pxIterator;
-	pxIterator->pxNext = ( volatile xListItem * ) pxNewListItem;
+	pxIterator->pxNext = ( volatile xListItem portOBJECT_SPACE * ) pxNewListItem;
 
 	/* Remember which list the item is in.  This allows fast removal of the
 	item later. */
-	pxNewListItem->pvContainer = ( void * ) pxList;
+	pxNewListItem->pvContainer = ( void portOBJECT_SPACE * ) pxList;
 
 	( pxList->usNumberOfItems )++;
 }
 /*-----------------------------------------------------------*/
 
-void vListRemove( xListItem *pxItemToRemove )
+void vListRemove( xListItem portOBJECT_SPACE *pxItemToRemove )
 {
-xList * pxList;
+xList portOBJECT_SPACE * pxList;
 
 	pxItemToRemove->pxNext->pxPrevious = pxItemToRemove->pxPrevious;
 	pxItemToRemove->pxPrevious->pxNext = pxItemToRemove->pxNext;
 	
 	/* The list item knows which list it is in.  Obtain the list from the list
 	item. */
-	pxList = ( xList * ) pxItemToRemove->pvContainer;
+	pxList = ( xList portOBJECT_SPACE * ) pxItemToRemove->pvContainer;
 
 	/* Make sure the index is left pointing to a valid item. */
 	if( pxList->pxIndex == pxItemToRemove )
@@ -42,20 +42,346 @@
 #include "portable.h"
 #include "task.h"
 
-/* Constants required to setup timer 2 to produce the RTOS tick. */
-#define portCLOCK_DIVISOR				( ( unsigned portLONG ) 12 )
-#define portMAX_TIMER_VALUE				( ( unsigned portLONG ) 0xffff )
+/* Constants required to setup the timers. */
 #define portENABLE_TIMER				( ( unsigned portCHAR ) 0x04 )
-#define portTIMER_2_INTERRUPT_ENABLE	( ( unsigned portCHAR ) 0x20 )
+#define portTIMER_3_INTERRUPT_ENABLE	( ( unsigned portCHAR ) 0x01 )
+#define portTIMER_3_HIGH_PRIORITY		( ( unsigned portCHAR ) 0x01 )
+
+/*-----------------------------------------------------------
+ * Tick source selection.  Everything here is resolved by the preprocessor 
+ * from portCPU_CLOCK, portTICK_RATE and portTICK_SOURCE.
+ *----------------------------------------------------------*/
+
+#if ( portCPU_CLOCK % portTICK_RATE ) != 0
+	#error "portCPU_CLOCK is not an exact multiple of portTICK_RATE."
+#endif
+
+#if ( portTICK_SOURCE == portTICK_SOURCE_TIMER_3 ) && ( portUSE_PREEMPTION == 1 )
+	#error "Timer 3 generates the portYIELD_FROM_ISR() interrupt so cannot be the tick source of the preemptive scheduler."
+#endif
+
+/* The number of SYSCLK cycles in one tick period. */
+#define portTICK_CLOCKS				( portCPU_CLOCK / portTICK_RATE )
+
+/* True if a prescaler of ucDivisor gives a whole number of timer counts per
+tick that fits within the 16 bit timer. */
+#define portPRESCALER_FITS( ucDivisor )	( ( ( portTICK_CLOCKS % ( ucDivisor ) ) == 0 ) && ( ( portTICK_CLOCKS / ( ucDivisor ) ) <= 65535 ) )
+
+/* Each source defines:
+
+portTICK_PRESCALER - the largest prescaler that generates the tick rate 
+exactly.
+
+portTICK_CLOCK_MODE - the value that selects portTICK_PRESCALER.
+
+portTICK_SFR_PAGE - the SFR page of the registers used.
+
+portTICK_AUTO_RELOAD - 1 if the hardware reloads the timer, in which case the
+register names are also defined for use by the generic code. */
+#if ( portTICK_SOURCE == portTICK_SOURCE_TIMER_2 ) || ( portTICK_SOURCE == portTICK_SOURCE_TIMER_3 ) || ( portTICK_SOURCE == portTICK_SOURCE_TIMER_4 )
+
+	/* TnM1:TnM0 in TMRnCF. */
+	#if portPRESCALER_FITS( 12 )
+		#define portTICK_PRESCALER		12
+		#define portTICK_CLOCK_MODE		( ( unsigned portCHAR ) 0x00 )
+	#elif portPRESCALER_FITS( 2 )
+		#define portTICK_PRESCALER		2
+		#define portTICK_CLOCK_MODE		( ( unsigned portCHAR ) 0x18 )
+	#elif portPRESCALER_FITS( 1 )
+		#define portTICK_PRESCALER		1
+		#define portTICK_CLOCK_MODE		( ( unsigned portCHAR ) 0x08 )
+	#else
+		#error "The tick rate cannot be generated exactly by timer 2, 3 or 4 - adjust portTICK_RATE."
+	#endif
+
+	#define portTICK_AUTO_RELOAD	1
+
+	/* The slowest prescaler, used while the tick is suppressed so a single
+	sleep can span as many tick periods as possible.  It need not generate the
+	tick rate exactly (see vPortSuppressTicksAndSleep()). */
+	#define portSLEEP_PRESCALER		12
+	#define portSLEEP_CLOCK_MODE	( ( unsigned portCHAR ) 0x00 )
+
+	#if portTICK_SOURCE == portTICK_SOURCE_TIMER_2
+		#define portTICK_SFR_PAGE		( ( unsigned portCHAR ) 0x00 )
+		#define portTICK_TMRCN			TMR2CN
+		#define portTICK_TMRCF			TMR2CF
+		#define portTICK_RCAPL			RCAP2L
+		#define portTICK_RCAPH			RCAP2H
+		#define portTICK_TMRL			TMR2L
+		#define portTICK_TMRH			TMR2H
+		#define portTICK_RUN			TR2
+		#define portTICK_FLAG			TF2
+		#define portTICK_FLAG_ASM		_TF2
+		#define portTICK_TMRL_ASM		_TMR2L
+		#define portTICK_TMRH_ASM		_TMR2H
+		#define portENABLE_TICK_INTERRUPT()	IE |= ( unsigned portCHAR ) 0x20;
+	#elif portTICK_SOURCE == portTICK_SOURCE_TIMER_3
+		#define portTICK_SFR_PAGE		( ( unsigned portCHAR ) 0x01 )
+		#define portTICK_TMRCN			TMR3CN
+		#define portTICK_TMRCF			TMR3CF
+		#define portTICK_RCAPL			RCAP3L
+		#define portTICK_RCAPH			RCAP3H
+		#define portTICK_TMRL			TMR3L
+		#define portTICK_TMRH			TMR3H
+		#define portTICK_RUN			TR3
+		#define portTICK_FLAG			TF3
+		#define portTICK_FLAG_ASM		_TF3
+		#define portTICK_TMRL_ASM		_TMR3L
+		#define portTICK_TMRH_ASM		_TMR3H
+		#define portENABLE_TICK_INTERRUPT()	EIE2 |= ( unsigned portCHAR ) 0x01;
+	#else
+		#define portTICK_SFR_PAGE		( ( unsigned portCHAR ) 0x02 )
+		#define portTICK_TMRCN			TMR4CN
+		#define portTICK_TMRCF			TMR4CF
+		#define portTICK_RCAPL			RCAP4L
+		#define portTICK_RCAPH			RCAP4H
+		#define portTICK_TMRL			TMR4L
+		#define portTICK_TMRH			TMR4H
+		#define portTICK_RUN			TR4
+		#define portTICK_FLAG			TF4
+		#define portTICK_FLAG_ASM		_TF4
+		#define portTICK_TMRL_ASM		_TMR4L
+		#define portTICK_TMRH_ASM		_TMR4H
+		#define portENABLE_TICK_INTERRUPT()	EIE2 |= ( unsigned portCHAR ) 0x04;
+	#endif
+
+	/* The overflow flag must be cleared by software. */
+	#define portACKNOWLEDGE_TICK_INTERRUPT()											\
+	{																				\
+		SFRPAGE = portTICK_SFR_PAGE;												\
+		portTICK_TMRCN &= ~0x80;													\
+	}
+
+#elif portTICK_SOURCE == portTICK_SOURCE_PCA
+
+	/* CPS2:CPS0 in PCA0MD. */
+	#if portPRESCALER_FITS( 12 )
+		#define portTICK_PRESCALER		12
+		#define portTICK_CLOCK_MODE		( ( unsigned portCHAR ) 0x00 )
+	#elif portPRESCALER_FITS( 4 )
+		#define portTICK_PRESCALER		4
+		#define portTICK_CLOCK_MODE		( ( unsigned portCHAR ) 0x02 )
+	#elif portPRESCALER_FITS( 1 )
+		#define portTICK_PRESCALER		1
+		#define portTICK_CLOCK_MODE		( ( unsigned portCHAR ) 0x08 )
+	#else
+		#error "The tick rate cannot be generated exactly by the PCA - adjust portTICK_RATE."
+	#endif
+
+	#define portTICK_AUTO_RELOAD		0
+	#define portTICK_SFR_PAGE			( ( unsigned portCHAR ) 0x00 )
+
+	/* Module 0 is used as a software timer - ECOM, MAT and ECCF set. */
+	#define portPCA_SOFTWARE_TIMER		( ( unsigned portCHAR ) 0x49 )
+	#define portPCA_INTERRUPT_ENABLE	( ( unsigned portCHAR ) 0x08 )
+
+	/* The compare value is moved on by exactly one tick period, so the time
+	taken to reach this point does not affect the tick rate.  The low byte
+	must be written first as writing it disables the comparator, and writing
+	the high byte enables it again. */
+	#define portACKNOWLEDGE_TICK_INTERRUPT()											\
+	{																				\
+		SFRPAGE = portTICK_SFR_PAGE;												\
+		usNextTickCompare += ( unsigned portSHORT ) portTICK_COUNTS;				\
+		PCA0CPL0 = ( unsigned portCHAR ) ( usNextTickCompare & 0xff );			\
+		PCA0CPH0 = ( unsigned portCHAR ) ( usNextTickCompare >> 8 );				\
+		CCF0 = 0;																	\
+	}
+
+#elif portTICK_SOURCE == portTICK_SOURCE_TIMER_0
+
+	/* Timer 0 has no 16 bit auto-reload mode.  It is stopped while the reload
+	value is added to the count, and the time for which it is stopped is made 
+	up by the reload value.  This is only exact when the timer is clocked 
+	directly by SYSCLK (T0M set in CKCON), as the prescaler would continue to 
+	run while the timer is stopped. */
+	#if portPRESCALER_FITS( 1 )
+		#define portTICK_PRESCALER		1
+		#define portTICK_CLOCK_MODE		( ( unsigned portCHAR ) 0x08 )
+	#else
+		#error "Timer 0 cannot generate the tick rate exactly - it requires portTICK_RATE >= portCPU_CLOCK / 65535."
+	#endif
+
+	#define portTICK_AUTO_RELOAD		0
+	#define portTICK_SFR_PAGE			( ( unsigned portCHAR ) 0x00 )
+	#define portTIMER_0_16_BIT_MODE		( ( unsigned portCHAR ) 0x01 )
+	#define portTIMER_0_MODE_MASK		( ( unsigned portCHAR ) 0x0f )
+
+	/* The number of clocks for which portACKNOWLEDGE_TICK_INTERRUPT() stops
+	the timer - from the end of the clr to the end of the setb, taken from
+	the CIP-51 instruction timings. */
+	#define portTIMER_0_STOPPED_CLOCKS	12
+
+	/* TF0 is cleared by hardware when the interrupt is vectored.  R6 and R7 
+	can be used as the context has already been saved. */
+	#define portACKNOWLEDGE_TICK_INTERRUPT()											\
+	{																				\
+		SFRPAGE = portTICK_SFR_PAGE;												\
+		portRELOAD_TIMER_0															\
+	}
+
+	#define portRELOAD_TIMER_0															\
+		_asm																			\
+			mov		dptr,#_usTimer0Reload											\
+			clr		a																\
+			movc	a,@a+dptr														\
+			mov		r6,a															\
+			mov		a,#0x01															\
+			movc	a,@a+dptr														\
+			mov		r7,a															\
+			clr		_TR0															\
+			mov		a,_TL0															\
+			add		a,r6															\
+			mov		_TL0,a															\
+			mov		a,_TH0															\
+			addc	a,r7															\
+			mov		_TH0,a															\
+			setb	_TR0															\
+		_endasm;
+
+#endif
+
+/* The number of timer counts in one tick period. */
+#define portTICK_COUNTS				( portTICK_CLOCKS / portTICK_PRESCALER )
+
+/* Value from which an auto-reload timer counts up to overflow each tick. */
+#define portTIMER_RELOAD_VALUE		( ( unsigned portSHORT ) ( 65536UL - ( unsigned portLONG ) portTICK_COUNTS ) )
+
+#if portTICK_SOURCE == portTICK_SOURCE_PCA
+
+	/* The PCA count at which the next tick is generated. */
+	xdata static unsigned portSHORT usNextTickCompare = ( unsigned portSHORT ) 0;
+
+#endif
+
+#if portTICK_SOURCE == portTICK_SOURCE_TIMER_0
+
+	/* Added to the timer 0 count each tick.  Held in code memory so the reload
+	sequence takes a fixed number of cycles. */
+	code const unsigned portSHORT usTimer0Reload = ( unsigned portSHORT ) ( 65536UL - ( unsigned portLONG ) portTICK_COUNTS + ( unsigned portLONG ) portTIMER_0_STOPPED_CLOCKS );
+
+#endif
+
+#if USE_TRACE_FACILITY == 1
+
+	/* The tick timer count at which the current tick period started, and a
+	macro to read the count.  Reading PCA0L latches PCA0H so the PCA count can
+	be read low byte first.  The other timers do not latch, so the high byte is
+	read again in case the low byte overflowed into it between the reads. */
+	#if portTICK_SOURCE == portTICK_SOURCE_PCA
+
+		#define portTICK_PERIOD_START		( ( unsigned portSHORT ) ( usNextTickCompare - ( unsigned portSHORT ) portTICK_COUNTS ) )
+
+		#define portREAD_TICK_TIMER( usCount )										\
+		{																			\
+			usCount = ( unsigned portSHORT ) PCA0L;									\
+			usCount |= ( unsigned portSHORT ) PCA0H << 8;							\
+		}
+
+	#else
+
+		#if portTICK_SOURCE == portTICK_SOURCE_TIMER_0
+			#define portTICK_TMRL			TL0
+			#define portTICK_TMRH			TH0
+		#endif
+
+		/* The timer 0 reload makes up for the time the timer is stopped, so 
+		the count relative to the reload value is exact for timer 0 too. */
+		#define portTICK_PERIOD_START		portTIMER_RELOAD_VALUE
+
+		#define portREAD_TICK_TIMER( usCount )										\
+		{																			\
+			do																		\
+			{																		\
+				usCount = ( unsigned portSHORT ) portTICK_TMRH << 8;				\
+				usCount |= ( unsigned portSHORT ) portTICK_TMRL;					\
+			} while( ( unsigned portCHAR ) ( usCount >> 8 ) != portTICK_TMRH );		\
+		}
+
+	#endif
+
+	/* The most tick timer counts seen between the start of a tick period and
+	the tick interrupt being ready to return - the interrupt latency, the 
+	kernel and the stack copies are included. */
+	xdata static unsigned portSHORT usMaxTickCounts = ( unsigned portSHORT ) 0;
+	xdata static unsigned portSHORT usTickCounts;
+
+	/* The highest tick timer value seen as the first stage of the tick ISR 
+	returns without calling the kernel.  This is recorded by assembly code, 
+	which compares the timer value directly rather than subtracting the reload
+	value, so is kept apart from usMaxTickCounts. */
+	#if ( portUSE_PREEMPTION == 1 ) && ( portUSE_TICK_FAST_PATH == 1 ) && ( USE_16_BIT_TICKS == 1 ) && ( portTICK_AUTO_RELOAD == 1 )
+		#define portRECORD_FAST_TICK_DURATION	1
+		xdata unsigned portSHORT usMaxFastTickTimer = portTIMER_RELOAD_VALUE;
+	#endif
+
+	/* Called by the tick ISR once the tick has been acknowledged, so the start
+	of the tick period is known, and any stacks have been copied - just before
+	the context is restored. */
+	#define portRECORD_TICK_DURATION()												\
+	{																				\
+		SFRPAGE = portTICK_SFR_PAGE;												\
+		portREAD_TICK_TIMER( usTickCounts );										\
+		usTickCounts -= portTICK_PERIOD_START;										\
+		if( usTickCounts > usMaxTickCounts )										\
+		{																			\
+			usMaxTickCounts = usTickCounts;											\
+		}																			\
+	}
+
+#else
+
+	#define portRECORD_TICK_DURATION()
+
+#endif
+/*-----------------------------------------------------------*/
 
 /* The value used in the IE register when a task first starts. */
 #define portGLOBAL_INTERRUPT_BIT	( ( portSTACK_TYPE ) 0x80 )
+#if portUSE_KERNEL_INTERRUPT_MASKING == 1
+	#define portINITIAL_IE			( portGLOBAL_INTERRUPT_BIT | ( portSTACK_TYPE ) portKERNEL_IE_MASK )
+#else
+	#define portINITIAL_IE			portGLOBAL_INTERRUPT_BIT
+#endif
 
 /* The value used in the PSW register when a task first starts. */
 #define portINITIAL_PSW				( ( portSTACK_TYPE ) 0x00 )
 
-/* Macro to clear the timer 2 interrupt flag. */
-#define portCLEAR_INTERRUPT_FLAG()	TMR2CN &= ~0x80;
+/* The number of tick periods an auto-reload timer can count when clocked by
+the sleep prescaler, which limits the length of a single sleep when the tick
+is suppressed. */
+#define portMAX_SUPPRESSED_TICKS	( ( portTickType ) ( ( 65535UL * ( unsigned portLONG ) portSLEEP_PRESCALER ) / ( unsigned portLONG ) portTICK_CLOCKS ) )
+
+#if ( portUSE_TICKLESS_IDLE == 1 ) && ( portTICK_AUTO_RELOAD == 0 )
+	#error "Tickless idle requires timer 2, 3 or 4 as the tick source."
+#endif
+
+/* SDCC defines SDCC_USE_XSTACK when --xstack is used.  The port option must
+match the code generated by the compiler. */
+#if ( portUSE_EXTERNAL_STACK == 1 ) && !defined( SDCC_USE_XSTACK )
+	#error "portUSE_EXTERNAL_STACK requires all files to be built with --xstack."
+#endif
+
+#if ( portUSE_EXTERNAL_STACK == 0 ) && defined( SDCC_USE_XSTACK )
+	#error "Set portUSE_EXTERNAL_STACK to 1 when building with --xstack."
+#endif
+
+#if ( portUSE_EXTERNAL_STACK == 1 ) && ( portNUM_STACK_SLOTS > 0 )
+	#error "Tasks with a resident stack slot have no external stack."
+#endif
+
+#if ( portUSE_EXTERNAL_STACK == 1 ) && defined( SDCC_MODEL_MEDIUM )
+	#error "The medium model places variables in pdata, which is used for the external stacks."
+#endif
+
+/* Lets vPortSuppressTicksAndSleep() know whether the tick interrupt ran while
+the CPU was asleep. */
+#if portUSE_TICKLESS_IDLE == 1
+	#define portRECORD_TICK()		ucTickDuringSleep = pdTRUE;
+#else
+	#define portRECORD_TICK()
+#endif
 
 /* Used during a context switch to store the size of the stack being copied
 to or from XRAM. */
@@ -69,82 +395,638 @@ xdata static portSTACK_TYPE * data pxXRAMStack;
 an XRAM byte is to be copied. */
 data static portSTACK_TYPE * data pxRAMStack;
 
+/* The critical section nesting count of the running task, with the state of
+EA on entry to the outermost critical section held in the top bit.  See
+portENTER_CRITICAL() in portmacro.h.  This forms part of the task context. */
+data unsigned portCHAR ucCriticalNesting = portNO_CRITICAL_NESTING;
+
 /* We require the address of the pxCurrentTCB variable, but don't want to know
 any details of its type. */
 typedef void tskTCB;
-extern volatile tskTCB * volatile pxCurrentTCB;
+extern volatile tskTCB portOBJECT_SPACE * volatile portKERNEL_HOT_DATA pxCurrentTCB;
+
+/* The first stage of the tick ISR increments the tick count directly, and
+only calls into the kernel once the tick count reaches or passes 
+xNextTaskUnblockTime. */
+extern volatile portTickType portKERNEL_DATA xTickCount;
+extern volatile portTickType portKERNEL_DATA xNextTaskUnblockTime;
+
+/* Used during a context switch to remember which task was executing before
+vTaskSwitchContext() was called.  If the scheduler selects the same task again
+the stack is already in place and need not be copied anywhere.  This is left
+in XRAM as placing it in data memory would take idata from the stack. */
+static volatile tskTCB portOBJECT_SPACE * xdata pxOutgoingTCB;
+
+/* The number of context switches for which the stack copies were skipped
+because the scheduler selected the task that was already running. */
+xdata static unsigned portLONG ulSkippedStackCopies = ( unsigned portLONG ) 0;
+
+#if portUSE_TICKLESS_IDLE == 1
+
+	/* Set by the tick ISR so vPortSuppressTicksAndSleep() can tell whether
+	the CPU was woken by the end of the suppressed tick period or by some 
+	other interrupt. */
+	xdata static volatile unsigned portCHAR ucTickDuringSleep = pdFALSE;
+
+	/* The SYSCLK cycles by which the tick timer was left behind when it was
+	restored after the last sleep, as it can only be set to a whole number of
+	counts.  These are added to the next sleep so the tick does not drift. */
+	xdata static unsigned portCHAR ucCarriedClocks = ( unsigned portCHAR ) 0;
+
+#endif
+
+#if ( portNUM_STACK_SLOTS > 0 ) || ( USE_TRACE_FACILITY == 1 )
+
+	/* The port needs to know whether a task has a resident stack slot, and 
+	records the stack depth of each task, but again does not want to know the
+	details of the TCB.  This matches the first members of the TCB structure
+	defined in tasks.c. */
+	typedef struct xTCB_HEADER
+	{
+		portSTACK_TYPE portOBJECT_SPACE *pxTopOfStack;
+		#if portNUM_STACK_SLOTS > 0
+			unsigned portCHAR ucStackSlot;
+		#endif
+		#if USE_TRACE_FACILITY == 1
+			unsigned portCHAR ucMaxStackBytes;
+		#endif
+	} xTCBHeader;
+
+#endif
+
+#if USE_TRACE_FACILITY == 1
+
+	#define portGET_MAX_STACK_BYTES( pxTCB )	( ( ( xTCBHeader portOBJECT_SPACE * ) ( pxTCB ) )->ucMaxStackBytes )
+
+	/* Record the deepest stack seen when switching a task out.  ucStackBytes
+	already holds the number of bytes on the stack, so this costs only a 
+	compare. */
+	#define portRECORD_STACK_DEPTH( pxTCB )															\
+	{																								\
+		if( ucStackBytes > portGET_MAX_STACK_BYTES( pxTCB ) )										\
+		{																							\
+			portGET_MAX_STACK_BYTES( pxTCB ) = ucStackBytes;										\
+		}																							\
+	}
+
+#else
+
+	#define portRECORD_STACK_DEPTH( pxTCB )
+
+#endif
+
+#if portNUM_STACK_SLOTS > 0
+
+	#define portGET_STACK_SLOT( pxTCB )	( ( ( xTCBHeader portOBJECT_SPACE * ) ( pxTCB ) )->ucStackSlot )
+
+	/* The stack pointer of each task that owns a stack slot, saved when the
+	task is switched out. */
+	xdata static unsigned portCHAR ucSlotStackPointer[ portNUM_STACK_SLOTS ];
+
+	/* Used during a context switch to hold the slot of the task being switched
+	in or out. */
+	xdata static unsigned portCHAR ucStackSlot;
+
+#endif
+
+#if portUSE_TASK_REGISTER_BANKS == 1
+
+	/* The tasks that keep R0-R7 in register banks 2 and 3 respectively while
+	they are not running.  Set by sPortSetTaskRegisterBank(). */
+	static volatile tskTCB portOBJECT_SPACE * xdata pxRegisterBankOwner[ portNUM_TASK_REGISTER_BANKS ];
+
+	/* The address of the last byte of the register bank used by the task that
+	is about to be switched out or in, or zero if the registers of the task 
+	are saved on the stack.  This is read by the assembly code so is kept in
+	data memory. */
+	data static unsigned portCHAR ucTaskRegisterBankTop = 0;
+
+	/* Reserve register banks 2 and 3.  The linker places the stack, and so
+	portSTACK_START, above these. */
+	data at 0x10 unsigned portCHAR ucTaskRegisterBanks[ portNUM_TASK_REGISTER_BANKS * portREGISTER_BANK_SIZE ];
+
+#endif
 
 /*
- * Setup the hardware to generate an interrupt off timer 2 at the required 
- * frequency.
+ * Setup the hardware to generate an interrupt off the tick source at the 
+ * required frequency.
  */
 static void prvSetupTimerInterrupt( void );
 
-/*-----------------------------------------------------------*/
 /*
- * Macro that copies the current stack from internal RAM to XRAM.  This is 
- * required as the 8051 only contains enough internal RAM for a single stack, 
- * but we have a stack for every task.
+ * Move the running tick timer on by usCounts counts.  The timer is stopped 
+ * only for the few instructions this takes.  Should the count pass the 
+ * overflow point the timer is set to overflow on the next count instead.
  */
-#define portCOPY_STACK_TO_XRAM()																\
-{																								\
-	/* pxCurrentTCB points to a TCB which itself points to the location into					\
-	which the first	stack byte should be copied.  Set pxXRAMStack to point						\
-	to the location into which the first stack byte is to be copied. */							\
-	pxXRAMStack = ( xdata portSTACK_TYPE * ) *( ( xdata portSTACK_TYPE ** ) pxCurrentTCB );		\
-																								\
-	/* Set pxRAMStack to point to the first byte to be coped from the stack. */					\
-	pxRAMStack = ( data portSTACK_TYPE * data ) portSTACK_START;								\
-																								\
-	/* Calculate the size of the stack we are about to copy from the current					\
-	stack pointer value. */																		\
-	ucStackBytes = SP - ( portSTACK_START - 1 );												\
-																								\
-	/* Before starting to copy the stack, store the calculated stack size so					\
-	the stack can be restored when the task is resumed. */										\
-	*pxXRAMStack = ucStackBytes;																\
-																								\
-	/* Copy each stack byte in turn.  pxXRAMStack is incremented first as we					\
-	have already stored the stack size into XRAM. */											\
-	while( ucStackBytes )																		\
+#if portUSE_TICKLESS_IDLE == 1
+	static void prvAdvanceTickTimer( unsigned portSHORT usCounts );
+#endif
+
+/*
+ * Setup the timer 3 interrupt used by portYIELD_FROM_ISR().  
+ */
+#if portUSE_PREEMPTION == 1
+	static void prvSetupYieldInterrupt( void );
+#endif
+
+/*
+ * Write the context that a task expects to find on its stack when it is first
+ * switched in, starting at pxStack.  A pointer to the last byte written is
+ * returned.  pxStack can point into either XRAM or idata.
+ */
+static portSTACK_TYPE *prvSetupInitialContext( portSTACK_TYPE *pxStack, pdTASK_CODE pxCode, void *pvParameters );
+/*-----------------------------------------------------------*/
+#if portUSE_PAGED_STACK_COPY == 1
+
+	/*
+	 * Macro that copies the current stack from internal RAM to XRAM.  This is 
+	 * required as the 8051 only contains enough internal RAM for a single 
+	 * stack, but we have a stack for every task.  pxTCB is the TCB of the task
+	 * that owns the stack.
+	 *
+	 * The XRAM stack of every task is contained within a single 256 byte page
+	 * (see portheap.c), so the copy can use MOVX @R1 with the page held in 
+	 * EMI0CN, instead of 16 bit DPTR arithmetic for each byte.  The loop is 
+	 * then five instructions, about 11 CIP-51 clocks, per byte.
+	 */
+	#define portCOPY_STACK_TO_XRAM( pxTCB )														\
 	{																							\
-		pxXRAMStack++;																			\
-		*pxXRAMStack = *pxRAMStack;																\
-		pxRAMStack++;																			\
-		ucStackBytes--;																			\
-	}																							\
-}
+		/* pxTCB points to a TCB which itself points to the location into						\
+		which the first	stack byte should be copied. */											\
+		pxXRAMStack = ( xdata portSTACK_TYPE * ) *( ( xdata portSTACK_TYPE ** ) pxTCB );		\
+		pxRAMStack = ( data portSTACK_TYPE * data ) portSTACK_START;							\
+		ucStackBytes = SP - ( portSTACK_START - 1 );											\
+		portRECORD_STACK_DEPTH( pxTCB );														\
+		portCOPY_STACK_TO_XRAM_PAGE																\
+	}
+
+	/* The loop for portCOPY_STACK_TO_XRAM().  This has no parameters so the
+	assembler immediate operator can be used. */
+	#define portCOPY_STACK_TO_XRAM_PAGE															\
+		_asm																					\
+			mov		r2,_SFRPAGE																	\
+			mov		_SFRPAGE,#0x00																\
+			mov		r3,_EMI0CN																	\
+			mov		_EMI0CN,(_pxXRAMStack + 1)													\
+			mov		r1,_pxXRAMStack																\
+			mov		r0,_pxRAMStack																\
+			/* Store the size first so the stack can be restored. */							\
+			mov		a,_ucStackBytes																\
+			movx	@r1,a																		\
+			mov		r4,a																		\
+		0096$:																					\
+			mov		a,@r0																		\
+			inc		r1																			\
+			movx	@r1,a																		\
+			inc		r0																			\
+			djnz	r4,0096$																	\
+			mov		_EMI0CN,r3																	\
+			mov		_SFRPAGE,r2																	\
+		_endasm;
+
+	/*
+	 * Macro that copies the stack of the task being resumed from XRAM into 
+	 * internal RAM.  pxTCB is the TCB of the task being resumed.
+	 */
+	#define portCOPY_XRAM_TO_STACK( pxTCB )														\
+	{																							\
+		pxXRAMStack = ( xdata portSTACK_TYPE * ) *( ( xdata portSTACK_TYPE ** ) pxTCB );		\
+		pxRAMStack = ( data portSTACK_TYPE * data ) ( portSTACK_START - 1 );					\
+		portCOPY_XRAM_PAGE_TO_STACK																\
+	}
+
+	/* The loop for portCOPY_XRAM_TO_STACK().  The first byte in XRAM is the 
+	number of bytes to copy.  SP is set to the last byte to be copied before
+	the copy starts - a high priority interrupt that occurs during the copy 
+	(see portUSE_KERNEL_INTERRUPT_MASKING) then saves its frame above the 
+	stack being restored, rather than within it. */
+	#define portCOPY_XRAM_PAGE_TO_STACK															\
+		_asm																					\
+			mov		r2,_SFRPAGE																	\
+			mov		_SFRPAGE,#0x00																\
+			mov		r3,_EMI0CN																	\
+			mov		_EMI0CN,(_pxXRAMStack + 1)													\
+			mov		r1,_pxXRAMStack																\
+			mov		r0,_pxRAMStack																\
+			movx	a,@r1																		\
+			mov		r4,a																		\
+			add		a,r0																		\
+			mov		SP,a																		\
+		0097$:																					\
+			inc		r1																			\
+			movx	a,@r1																		\
+			inc		r0																			\
+			mov		@r0,a																		\
+			djnz	r4,0097$																	\
+			mov		_EMI0CN,r3																	\
+			mov		_SFRPAGE,r2																	\
+		_endasm;
+
+#else
+
+	/*
+	 * Macro that copies the current stack from internal RAM to XRAM.  This is 
+	 * required as the 8051 only contains enough internal RAM for a single stack, 
+	 * but we have a stack for every task.  pxTCB is the TCB of the task that
+	 * owns the stack.
+	 */
+	#define portCOPY_STACK_TO_XRAM( pxTCB )															\
+	{																								\
+		/* pxTCB points to a TCB which itself points to the location into							\
+		which the first	stack byte should be copied.  Set pxXRAMStack to point						\
+		to the location into which the first stack byte is to be copied. */							\
+		pxXRAMStack = ( xdata portSTACK_TYPE * ) *( ( xdata portSTACK_TYPE ** ) pxTCB );			\
+																									\
+		/* Set pxRAMStack to point to the first byte to be coped from the stack. */					\
+		pxRAMStack = ( data portSTACK_TYPE * data ) portSTACK_START;								\
+																									\
+		/* Calculate the size of the stack we are about to copy from the current					\
+		stack pointer value. */																		\
+		ucStackBytes = SP - ( portSTACK_START - 1 );												\
+		portRECORD_STACK_DEPTH( pxTCB );															\
+																									\
+		/* Before starting to copy the stack, store the calculated stack size so					\
+		the stack can be restored when the task is resumed. */										\
+		*pxXRAMStack = ucStackBytes;																\
+																									\
+		/* Copy each stack byte in turn.  pxXRAMStack is incremented first as we					\
+		have already stored the stack size into XRAM. */											\
+		while( ucStackBytes )																		\
+		{																							\
+			pxXRAMStack++;																			\
+			*pxXRAMStack = *pxRAMStack;																\
+			pxRAMStack++;																			\
+			ucStackBytes--;																			\
+		}																							\
+	}
+
+	/*
+	 * Macro that copies the stack of the task being resumed from XRAM into 
+	 * internal RAM.  pxTCB is the TCB of the task being resumed.
+	 */
+	#define portCOPY_XRAM_TO_STACK( pxTCB )															\
+	{																								\
+		/* Setup the pointers as per portCOPY_STACK_TO_XRAM(), but this time to						\
+		copy the data back out of XRAM and into the stack. */										\
+		pxXRAMStack = ( xdata portSTACK_TYPE * ) *( ( xdata portSTACK_TYPE ** ) pxTCB );			\
+		pxRAMStack = ( data portSTACK_TYPE * data ) ( portSTACK_START - 1 );						\
+																									\
+		/* The first value stored in XRAM was the size of the stack - i.e. the						\
+		number of bytes we need to copy back. */													\
+		ucStackBytes = pxXRAMStack[ 0 ];															\
+																									\
+		/* Set the stack pointer to the last byte to be restored before copying,					\
+		so an interrupt that occurs during the copy saves its frame above the						\
+		stack being restored rather than within it. */												\
+		SP = ( unsigned portCHAR ) pxRAMStack + ucStackBytes;										\
+																									\
+		/* Copy the required number of bytes back into the stack. */								\
+		do																							\
+		{																							\
+			pxXRAMStack++;																			\
+			pxRAMStack++;																			\
+			*pxRAMStack = *pxXRAMStack;																\
+			ucStackBytes--;																			\
+		} while( ucStackBytes );																	\
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if portNUM_STACK_SLOTS > 0
+
+	/*
+	 * Tasks that own a stack slot in idata never have their stack copied.
+	 * Switching such a task out or in only requires its stack pointer to be
+	 * saved or restored, whereas a task without a slot has its stack copied 
+	 * between the common stack area (starting at portSTACK_START) and XRAM.
+	 *
+	 * The copy loops cost in the order of twenty instructions per byte, so 
+	 * a task switched out with 60 bytes on the stack and back in later costs 
+	 * well over two thousand instructions in copies alone.  Saving or 
+	 * restoring SP from ucSlotStackPointer[] costs under twenty.
+	 */
+	#define portSWITCH_STACK_OUT( pxTCB )														\
+	{																							\
+		ucStackSlot = portGET_STACK_SLOT( pxTCB );												\
+		if( ucStackSlot == portNO_STACK_SLOT )													\
+		{																						\
+			portCOPY_STACK_TO_XRAM( pxTCB );													\
+		}																						\
+		else																					\
+		{																						\
+			ucSlotStackPointer[ ucStackSlot ] = SP;												\
+			portRECORD_SLOT_STACK_DEPTH( pxTCB );												\
+		}																						\
+	}
+
+	/* The stack of a task in a slot is not copied, so the depth is only 
+	calculated if it is to be recorded. */
+	#if USE_TRACE_FACILITY == 1
+		#define portRECORD_SLOT_STACK_DEPTH( pxTCB )											\
+		{																						\
+			ucStackBytes = SP - ( ( portSTACK_SLOT_START - 1 ) + ( ucStackSlot * portSTACK_SLOT_SIZE ) );	\
+			portRECORD_STACK_DEPTH( pxTCB );													\
+		}
+	#else
+		#define portRECORD_SLOT_STACK_DEPTH( pxTCB )
+	#endif
+
+	#define portSWITCH_STACK_IN( pxTCB )														\
+	{																							\
+		ucStackSlot = portGET_STACK_SLOT( pxTCB );												\
+		if( ucStackSlot == portNO_STACK_SLOT )													\
+		{																						\
+			portCOPY_XRAM_TO_STACK( pxTCB );													\
+		}																						\
+		else																					\
+		{																						\
+			SP = ucSlotStackPointer[ ucStackSlot ];												\
+		}																						\
+	}
+
+#else
+
+	#define portSWITCH_STACK_OUT( pxTCB )	portCOPY_STACK_TO_XRAM( pxTCB )
+	#define portSWITCH_STACK_IN( pxTCB )	portCOPY_XRAM_TO_STACK( pxTCB )
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if portUSE_TASK_REGISTER_BANKS == 1
+
+	/*
+	 * Set ucTaskRegisterBankTop for the task that is about to be switched in,
+	 * so portRESTORE_CONTEXT() (and the next portSAVE_CONTEXT()) know where 
+	 * its R0-R7 are kept.
+	 */
+	#define portSELECT_REGISTER_BANK( pxTCB )													\
+	{																							\
+		if( ( pxTCB ) == pxRegisterBankOwner[ 0 ] )												\
+		{																						\
+			ucTaskRegisterBankTop = portREGISTER_BANK_TOP( 2 );									\
+		}																						\
+		else if( ( pxTCB ) == pxRegisterBankOwner[ 1 ] )										\
+		{																						\
+			ucTaskRegisterBankTop = portREGISTER_BANK_TOP( 3 );									\
+		}																						\
+		else																					\
+		{																						\
+			ucTaskRegisterBankTop = 0;															\
+		}																						\
+	}
+
+	/*
+	 * Save R0-R7 of the task being switched out.  A task that has its own 
+	 * register bank has R0-R7 copied into that bank (R0 is parked in B, 
+	 * which has already been saved, while R0 is used as the pointer).  Other
+	 * tasks push R0-R7 as part of the context.  Nothing here alters PSW, 
+	 * which is saved next.  
+	 *
+	 * The bank copy costs the same as the pushes, but takes eight bytes off
+	 * the frame and so off both stack copies on every switch.
+	 */
+	#define portSAVE_REGISTERS()																\
+	{																							\
+		_asm																					\
+			mov		a,_ucTaskRegisterBankTop													\
+			jz		0092$																		\
+			mov		b,r0																		\
+			mov		r0,a																		\
+			mov		@r0,ar7																		\
+			dec		r0																			\
+			mov		@r0,ar6																		\
+			dec		r0																			\
+			mov		@r0,ar5																		\
+			dec		r0																			\
+			mov		@r0,ar4																		\
+			dec		r0																			\
+			mov		@r0,ar3																		\
+			dec		r0																			\
+			mov		@r0,ar2																		\
+			dec		r0																			\
+			mov		@r0,ar1																		\
+			dec		r0																			\
+			mov		@r0,b																		\
+			sjmp	0093$																		\
+		0092$:																					\
+			push	ar2																			\
+			push	ar3																			\
+			push	ar4																			\
+			push	ar5																			\
+			push	ar6																			\
+			push	ar7																			\
+			push	ar0																			\
+			push	ar1																			\
+		0093$:																					\
+		_endasm;																				\
+	}
+
+	/*
+	 * The reverse of portSAVE_REGISTERS(), executed after PSW has been 
+	 * restored - so again must not alter the flags.  R0 is used as the pointer
+	 * so is restored last.
+	 */
+	#define portRESTORE_REGISTERS()																\
+	{																							\
+		_asm																					\
+			mov		a,_ucTaskRegisterBankTop													\
+			jz		0094$																		\
+			mov		r0,a																		\
+			mov		ar7,@r0																		\
+			dec		r0																			\
+			mov		ar6,@r0																		\
+			dec		r0																			\
+			mov		ar5,@r0																		\
+			dec		r0																			\
+			mov		ar4,@r0																		\
+			dec		r0																			\
+			mov		ar3,@r0																		\
+			dec		r0																			\
+			mov		ar2,@r0																		\
+			dec		r0																			\
+			mov		ar1,@r0																		\
+			dec		r0																			\
+			mov		ar0,@r0																		\
+			sjmp	0095$																		\
+		0094$:																					\
+			pop		ar1																			\
+			pop		ar0																			\
+			pop		ar7																			\
+			pop		ar6																			\
+			pop		ar5																			\
+			pop		ar4																			\
+			pop		ar3																			\
+			pop		ar2																			\
+		0095$:																					\
+		_endasm;																				\
+	}
+
+#else
+
+	#define portSELECT_REGISTER_BANK( pxTCB )
+
+	#define portSAVE_REGISTERS()																\
+	{																							\
+		_asm																					\
+			push	ar2																			\
+			push	ar3																			\
+			push	ar4																			\
+			push	ar5																			\
+			push	ar6																			\
+			push	ar7																			\
+			push	ar0																			\
+			push	ar1																			\
+		_endasm;																				\
+	}
+
+	#define portRESTORE_REGISTERS()																\
+	{																							\
+		_asm																					\
+			pop		ar1																			\
+			pop		ar0																			\
+			pop		ar7																			\
+			pop		ar6																			\
+			pop		ar5																			\
+			pop		ar4																			\
+			pop		ar3																			\
+			pop		ar2																			\
+		_endasm;																				\
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if portUSE_EXTERNAL_STACK == 1
+
+	/*
+	 * Point EMI0CN at the XRAM page of the task that is about to be switched
+	 * in, so the external stack accesses (MOVX @Ri) made by the task use its 
+	 * own external stack.  The page is the high byte of the address held in 
+	 * the TCB.  _spx is restored with the rest of the context.
+	 */
+	#define portSELECT_EXTERNAL_STACK( pxTCB )													\
+	{																							\
+		pxXRAMStack = ( xdata portSTACK_TYPE * ) *( ( xdata portSTACK_TYPE ** ) pxTCB );		\
+		portSELECT_EXTERNAL_STACK_PAGE															\
+	}
+
+	/* This has no parameters so the assembler immediate operator can be 
+	used. */
+	#define portSELECT_EXTERNAL_STACK_PAGE														\
+		_asm																					\
+			mov		r2,_SFRPAGE																	\
+			mov		_SFRPAGE,#0x00																\
+			mov		_EMI0CN,(_pxXRAMStack + 1)													\
+			mov		_SFRPAGE,r2																	\
+		_endasm;
+
+	/* The external stack pointer is saved after _bp. */
+	#define portSAVE_EXTERNAL_STACK_POINTER														\
+		_asm																					\
+			push	_spx																		\
+		_endasm;
+
+	#define portRESTORE_EXTERNAL_STACK_POINTER													\
+		_asm																					\
+			pop		_spx																		\
+		_endasm;
+
+	/* The bytes saved after PSW - _bp, _spx and the critical nesting count. */
+	#define portFRAME_TAIL_BYTES		3
+
+#else
+
+	#define portSELECT_EXTERNAL_STACK( pxTCB )
+	#define portSAVE_EXTERNAL_STACK_POINTER
+	#define portRESTORE_EXTERNAL_STACK_POINTER
+
+	/* The bytes saved after PSW - _bp and the critical nesting count. */
+	#define portFRAME_TAIL_BYTES		2
+
+#endif
 /*-----------------------------------------------------------*/
 
 /*
- * Macro that copies the stack of the task being resumed from XRAM into 
- * internal RAM.
+ * Macro used once vTaskSwitchContext() has selected the next task to run.
+ * The stacks only need to be swapped if the selected task is not the task
+ * that was executing when the context was saved - in which case the stack
+ * of the task being switched out is copied to XRAM and the stack of the task
+ * being resumed copied out of XRAM.  Otherwise the stack is left where it is
+ * and the saved context is restored directly from it.
  */
-#define portCOPY_XRAM_TO_STACK()																\
+#define portSWITCH_STACKS()																		\
 {																								\
-	/* Setup the pointers as per portCOPY_STACK_TO_XRAM(), but this time to						\
-	copy the data back out of XRAM and into the stack. */										\
-	pxXRAMStack = ( xdata portSTACK_TYPE * ) *( ( xdata portSTACK_TYPE ** ) pxCurrentTCB );		\
-	pxRAMStack = ( data portSTACK_TYPE * data ) ( portSTACK_START - 1 );						\
-																								\
-	/* The first value stored in XRAM was the size of the stack - i.e. the						\
-	number of bytes we need to copy back. */													\
-	ucStackBytes = pxXRAMStack[ 0 ];															\
-																								\
-	/* Copy the required number of bytes back into the stack. */								\
-	do																							\
+	if( pxCurrentTCB != pxOutgoingTCB )															\
 	{																							\
-		pxXRAMStack++;																			\
-		pxRAMStack++;																			\
-		*pxRAMStack = *pxXRAMStack;																\
-		ucStackBytes--;																			\
-	} while( ucStackBytes );																	\
-																								\
-	/* Restore the stack pointer ready to use the restored stack. */							\
-	SP = ( unsigned portCHAR ) pxRAMStack;														\
+		portSWITCH_STACK_OUT( pxOutgoingTCB );													\
+		portSWITCH_STACK_IN( pxCurrentTCB );													\
+		portSELECT_REGISTER_BANK( pxCurrentTCB );												\
+		portSELECT_EXTERNAL_STACK( pxCurrentTCB );												\
+	}																							\
+	else																						\
+	{																							\
+		ulSkippedStackCopies++;																	\
+	}																							\
 }
 /*-----------------------------------------------------------*/
 
+#if portUSE_KERNEL_INTERRUPT_MASKING == 1
+
+	/* Only the kernel aware interrupts are held off while the context is 
+	switched.  High priority interrupts remain enabled throughout. */
+	#define portDISABLE_FOR_CONTEXT_SWITCH()	portMASK_KERNEL_INTERRUPTS()
+
+	/* Restore the interrupt state from the IE value saved as part of the task
+	context, which is held in ACC.  The global enable bit and the kernel 
+	interrupt mask (indicated by ET2, IE bit 5) form part of the task 
+	context. */
+	#define portRESTORE_INTERRUPT_STATE															\
+		_asm																					\
+			JB		ACC.7,0086$																	\
+			CLR		IE.7																		\
+			LJMP	0087$																		\
+		0086$:																					\
+			SETB	IE.7																		\
+		0087$:																					\
+			JB		ACC.5,0088$																	\
+			anl		IE,#(0xff - portKERNEL_IE_MASK)												\
+			anl		_EIE1,#(0xff - portKERNEL_EIE1_MASK)										\
+			anl		_EIE2,#(0xff - portKERNEL_EIE2_MASK)										\
+			LJMP	0089$																		\
+		0088$:																					\
+			orl		IE,#portKERNEL_IE_MASK														\
+			orl		_EIE1,#portKERNEL_EIE1_MASK													\
+			orl		_EIE2,#portKERNEL_EIE2_MASK													\
+		0089$:																					\
+		_endasm;
+
+#else
+
+	#define portDISABLE_FOR_CONTEXT_SWITCH()													\
+	{																							\
+		_asm																					\
+			clr		_EA																			\
+		_endasm;																				\
+	}
+
+	/* Restore the interrupt state from the IE value saved as part of the task
+	context, which is held in ACC.  Only the global enable bit forms part of 
+	the task context.  Set the global enable bit to match that of the stored 
+	IE register. */
+	#define portRESTORE_INTERRUPT_STATE															\
+		_asm																					\
+			JB		ACC.7,0098$																	\
+			CLR		IE.7																		\
+			LJMP	0099$																		\
+		0098$:																					\
+			SETB	IE.7																		\
+		0099$:																					\
+		_endasm;
+
+#endif
+/*-----------------------------------------------------------*/
+
 /*
  * Macro to push the current execution context onto the stack, before the stack 
  * is moved to XRAM. 
@@ -157,57 +1039,117 @@ static void prvSetupTimerInterrupt( void );
 		push	ACC																				\
 		/* Store the IE register then disable interrupts. */									\
 		push	IE																				\
-		clr		_EA																				\
+	_endasm;																					\
+	portDISABLE_FOR_CONTEXT_SWITCH();															\
+	_asm																						\
 		push	DPL																				\
 		push	DPH																				\
 		push	b																				\
-		push	ar2																				\
-		push	ar3																				\
-		push	ar4																				\
-		push	ar5																				\
-		push	ar6																				\
-		push	ar7																				\
-		push	ar0																				\
-		push	ar1																				\
+	_endasm;																					\
+	portSAVE_REMAINING_CONTEXT();																\
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * The second half of portSAVE_CONTEXT().  This is separate so the tick ISR
+ * can complete the context save after its first stage has already pushed
+ * ACC, IE, DPL, DPH and B.
+ */
+#define portSAVE_REMAINING_CONTEXT()															\
+{																								\
+	portSAVE_REGISTERS();																		\
+	_asm																						\
 		push	PSW																				\
 	_endasm;																					\
 		PSW = 0;																				\
 	_asm																						\
 		push	_bp																				\
 	_endasm;																					\
+	portSAVE_EXTERNAL_STACK_POINTER																\
+	_asm																						\
+		push	_ucCriticalNesting																\
+	_endasm;																					\
+	/* The critical nesting count and saved EA state belong to the task.  The			\
+	kernel code that follows starts with neither. */										\
+	ucCriticalNesting = portNO_CRITICAL_NESTING;												\
 }
 /*-----------------------------------------------------------*/
 
+/*
+ * Macro to push the context of a task that is calling vPortYield().  The task
+ * has made a function call, and SDCC functions do not preserve DPTR, B, R0-R7
+ * or the PSW flags for their caller, so only the interrupt state, _bp, _spx 
+ * (when the external stack is used) and the critical nesting count need to be
+ * kept.  ACC is pushed as well so the frame ends in the same way as a full 
+ * frame.  The frame is marked by setting portYIELD_FRAME_BIT in the saved 
+ * nesting count.
+ */
+#define portSAVE_YIELD_CONTEXT()																\
+{																								\
+	_asm																						\
+		push	ACC																				\
+		push	IE																				\
+	_endasm;																					\
+	portDISABLE_FOR_CONTEXT_SWITCH();															\
+	_asm																						\
+		push	_bp																				\
+	_endasm;																					\
+	portSAVE_EXTERNAL_STACK_POINTER																\
+	portPUSH_YIELD_NESTING																		\
+	ucCriticalNesting = portNO_CRITICAL_NESTING;												\
+}
+
+/* The nesting count with the frame marker set.  This has no parameters so 
+the assembler immediate operator can be used. */
+#define portYIELD_FRAME_BIT			0x40
+#define portPUSH_YIELD_NESTING																	\
+	_asm																						\
+		mov		a,_ucCriticalNesting															\
+		orl		a,#portYIELD_FRAME_BIT															\
+		push	ACC																				\
+	_endasm;
+
+#define portCLEAR_YIELD_FRAME_BIT																\
+	_asm																						\
+		anl		_ucCriticalNesting,#(0xff - portYIELD_FRAME_BIT)								\
+	_endasm;
+/*-----------------------------------------------------------*/
+
 /*
  * Macro that restores the execution context from the stack.  The execution 
  * context was saved into the stack before the stack was copied into XRAM.
+ * The frame is either the full frame saved by portSAVE_CONTEXT() or the 
+ * shorter frame saved by portSAVE_YIELD_CONTEXT().  Both end with IE then
+ * ACC, so share the same exit.
  */
 #define portRESTORE_CONTEXT()																	\
 {																								\
+	_asm																						\
+		pop		_ucCriticalNesting																\
+	_endasm;																					\
+	portRESTORE_EXTERNAL_STACK_POINTER															\
 	_asm																						\
 		pop		_bp																				\
+		mov		a,_ucCriticalNesting															\
+		jnb		ACC.6,0080$																		\
+	_endasm;																					\
+	portCLEAR_YIELD_FRAME_BIT																	\
+	_asm																						\
+		ljmp	0081$																			\
+	0080$:																						\
 		pop		PSW																				\
-		pop		ar1																				\
-		pop		ar0																				\
-		pop		ar7																				\
-		pop		ar6																				\
-		pop		ar5																				\
-		pop		ar4																				\
-		pop		ar3																				\
-		pop		ar2																				\
+	_endasm;																					\
+	portRESTORE_REGISTERS();																	\
+	_asm																						\
 		pop		b																				\
 		pop		DPH																				\
 		pop		DPL																				\
-		/* The next byte of the stack is the IE register.  Only the global						\
-		enable bit forms part of the task context.  Pop off the IE then set						\
-		the global enable bit to match that of the stored IE register. */						\
+	0081$:																						\
+		/* The next byte of the stack is the IE register. */									\
 		pop		ACC																				\
-		JB		ACC.7,0098$																		\
-		CLR		IE.7																			\
-		LJMP	0099$																			\
-	0098$:																						\
-		SETB	IE.7																			\
-	0099$:																						\
+	_endasm;																					\
+	portRESTORE_INTERRUPT_STATE																	\
+	_asm																						\
 		/* Finally pop off the ACC, which was the first register saved. */						\
 		pop		ACC																				\
 		reti																					\
@@ -220,13 +1162,11 @@ static void prvSetupTimerInterrupt( void );
  */
 portSTACK_TYPE *pxPortInitialiseStack( portSTACK_TYPE *pxTopOfStack, pdTASK_CODE pxCode, void *pvParameters )
 {
-unsigned portLONG ulAddress;
 portSTACK_TYPE *pxStartOfStack;
 
 	/* Leave space to write the size of the stack as the first byte. */
 	pxStartOfStack = pxTopOfStack;
 	pxTopOfStack++;
-
 	/* Place a few bytes of known values on the bottom of the stack. 
 	This is just useful for debugging and can be uncommented if required.
 	*pxTopOfStack = 0x11;
@@ -237,67 +1177,111 @@ portSTACK_TYPE *pxStartOfStack;
 	pxTopOfStack++;
 	*/
 
+	pxTopOfStack = prvSetupInitialContext( pxTopOfStack, pxCode, pvParameters );
+
+	/* Dont increment the stack size here as we don't want to include
+	the stack size byte as part of the stack size count.
+
+	Finally we place the stack size at the beginning. */
+	*pxStartOfStack = ( portSTACK_TYPE ) ( pxTopOfStack - pxStartOfStack );
+
+	/* Unlike most ports, we return the start of the stack as this is where the
+	size of the stack is stored. */
+	return pxStartOfStack;
+}
+/*-----------------------------------------------------------*/
+
+#if portNUM_STACK_SLOTS > 0
+
+	void vPortInitialiseStackSlot( unsigned portCHAR ucSlot, pdTASK_CODE pxCode, void *pvParameters )
+	{
+	portSTACK_TYPE *pxSlotStack;
+
+		/* The context is placed directly into the slot, and the stack pointer
+		left pointing to the last byte written - as if the task had been
+		switched out. */
+		pxSlotStack = ( idata portSTACK_TYPE * ) ( portSTACK_SLOT_START + ( ucSlot * portSTACK_SLOT_SIZE ) );
+		pxSlotStack = prvSetupInitialContext( pxSlotStack, pxCode, pvParameters );
+		ucSlotStackPointer[ ucSlot ] = ( unsigned portCHAR ) pxSlotStack;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+static portSTACK_TYPE *prvSetupInitialContext( portSTACK_TYPE *pxStack, pdTASK_CODE pxCode, void *pvParameters )
+{
+unsigned portLONG ulAddress;
+#if portUSE_EXTERNAL_STACK == 1
+	portSTACK_TYPE *pxStackStart = pxStack;
+#endif
+
 	/* Simulate how the stack would look after a call to the scheduler tick 
 	ISR. 
 
 	The return address that would have been pushed by the MCU. */
 	ulAddress = ( unsigned portLONG ) pxCode;
-	*pxTopOfStack = ( portSTACK_TYPE ) ulAddress;
+	*pxStack = ( portSTACK_TYPE ) ulAddress;
 	ulAddress >>= 8;
-	pxTopOfStack++;
-	*pxTopOfStack = ( portSTACK_TYPE ) ( ulAddress );
-	pxTopOfStack++;
+	pxStack++;
+	*pxStack = ( portSTACK_TYPE ) ( ulAddress );
+	pxStack++;
 
 	/* Next all the registers will have been pushed by portSAVE_CONTEXT(). */
-	*pxTopOfStack = 0xaa;	/* acc */
-	pxTopOfStack++;	
+	*pxStack = 0xaa;	/* acc */
+	pxStack++;	
 
 	/* We want tasks to start with interrupts enabled. */
-	*pxTopOfStack = portGLOBAL_INTERRUPT_BIT;
-	pxTopOfStack++;
+	*pxStack = portINITIAL_IE;
+	pxStack++;
 
 	/* The function parameters will be passed in the DPTR and B register as
 	a three byte generic pointer is used. */
 	ulAddress = ( unsigned portLONG ) pvParameters;
-	*pxTopOfStack = ( portSTACK_TYPE ) ulAddress;	/* DPL */
+	*pxStack = ( portSTACK_TYPE ) ulAddress;	/* DPL */
 	ulAddress >>= 8;
-	*pxTopOfStack++;
-	*pxTopOfStack = ( portSTACK_TYPE ) ulAddress;	/* DPH */
+	pxStack++;
+	*pxStack = ( portSTACK_TYPE ) ulAddress;	/* DPH */
 	ulAddress >>= 8;
-	pxTopOfStack++;
-	*pxTopOfStack = ( portSTACK_TYPE ) ulAddress;	/* b */
-	pxTopOfStack++;
+	pxStack++;
+	*pxStack = ( portSTACK_TYPE ) ulAddress;	/* b */
+	pxStack++;
 
 	/* The remaining registers are straight forward. */
-	*pxTopOfStack = 0x02;	/* R2 */
-	pxTopOfStack++;
-	*pxTopOfStack = 0x03;	/* R3 */
-	pxTopOfStack++;
-	*pxTopOfStack = 0x04;	/* R4 */
-	pxTopOfStack++;
-	*pxTopOfStack = 0x05;	/* R5 */
-	pxTopOfStack++;
-	*pxTopOfStack = 0x06;	/* R6 */
-	pxTopOfStack++;
-	*pxTopOfStack = 0x07;	/* R7 */
-	pxTopOfStack++;
-	*pxTopOfStack = 0x00;	/* R0 */
-	pxTopOfStack++;
-	*pxTopOfStack = 0x01;	/* R1 */
-	pxTopOfStack++;
-	*pxTopOfStack = 0x00;	/* PSW */
-	pxTopOfStack++;
-	*pxTopOfStack = 0xbb;	/* BP */
+	*pxStack = 0x02;	/* R2 */
+	pxStack++;
+	*pxStack = 0x03;	/* R3 */
+	pxStack++;
+	*pxStack = 0x04;	/* R4 */
+	pxStack++;
+	*pxStack = 0x05;	/* R5 */
+	pxStack++;
+	*pxStack = 0x06;	/* R6 */
+	pxStack++;
+	*pxStack = 0x07;	/* R7 */
+	pxStack++;
+	*pxStack = 0x00;	/* R0 */
+	pxStack++;
+	*pxStack = 0x01;	/* R1 */
+	pxStack++;
+	*pxStack = portINITIAL_PSW;	/* PSW */
+	pxStack++;
+	*pxStack = 0xbb;	/* BP */
+	pxStack++;
 
-	/* Dont increment the stack size here as we don't want to include
-	the stack size byte as part of the stack size count.
+	#if portUSE_EXTERNAL_STACK == 1
+	{
+		/* The external stack starts after the space reserved for the idata 
+		stack image, which includes the size byte that precedes pxStackStart.
+		It is in the same XRAM page so only the low byte is needed. */
+		*pxStack = ( portSTACK_TYPE ) ( ( unsigned portSHORT ) ( pxStackStart + ( portIDATA_IMAGE_SIZE - 1 ) ) );	/* SPX */
+		pxStack++;
+	}
+	#endif
 
-	Finally we place the stack size at the beginning. */
-	*pxStartOfStack = ( portSTACK_TYPE ) ( pxTopOfStack - pxStartOfStack );
+	/* Tasks start outside of any critical section. */
+	*pxStack = portNO_CRITICAL_NESTING;
 
-	/* Unlike most ports, we return the start of the stack as this is where the
-	size of the stack is stored. */
-	return pxStartOfStack;
+	return pxStack;
 }
 /*-----------------------------------------------------------*/
 
@@ -310,16 +1294,37 @@ portSHORT sPortStartScheduler( portSHORT sUsePreemption )
 	portmacro.h to specify whether or not preemption is used. */
 	( void ) sUsePreemption;
 
-	/* Setup timer 2 to generate the RTOS tick. */
+	/* Setup the tick source to generate the RTOS tick. */
 	prvSetupTimerInterrupt();	
 
+	#if portUSE_PREEMPTION == 1
+	{
+		prvSetupYieldInterrupt();
+	}
+	#endif
+
+	#if portUSE_KERNEL_INTERRUPT_MASKING == 1
+	{
+		/* Kernel aware interrupts must not be able to interrupt each other,
+		or be masked by a high priority interrupt, so force them to low 
+		priority.  The kernel aware interrupts will be unmasked when the first
+		task starts. */
+		IP &= ~portKERNEL_IE_MASK;
+		EIP1 &= ~portKERNEL_EIE1_MASK;
+		EIP2 &= ~portKERNEL_EIE2_MASK;
+	}
+	#endif
+
 	/* Make sure we start with the expected SFR page.  This line should not
 	really be required. */
 	SFRPAGE = 0;
 
-	/* Copy the stack for the first task to execute from XRAM into the stack,
-	restore the task context from the new stack, then start running the task. */
-	portCOPY_XRAM_TO_STACK();
+	/* Copy the stack for the first task to execute from XRAM into the stack
+	(or just point to its stack slot), restore the task context from the new 
+	stack, then start running the task. */
+	portSWITCH_STACK_IN( pxCurrentTCB );
+	portSELECT_REGISTER_BANK( pxCurrentTCB );
+	portSELECT_EXTERNAL_STACK( pxCurrentTCB );
 	portRESTORE_CONTEXT();
 
 	/* Should never get here! */
@@ -333,56 +1338,480 @@ void vPortEndScheduler( void )
 }
 /*-----------------------------------------------------------*/
 
+#if portUSE_TASK_REGISTER_BANKS == 1
+
+	portSHORT sPortSetTaskRegisterBank( xTaskHandle xTask, unsigned portCHAR ucBank )
+	{
+	portSTACK_TYPE *pxFrameEnd;
+	portSTACK_TYPE *pxStartOfStack;
+	unsigned portCHAR ucTailByte = 0;
+
+		if( ( ucBank < ( unsigned portCHAR ) 2 ) || ( ucBank > ( unsigned portCHAR ) 3 ) )
+		{
+			return pdFAIL;
+		}
+
+		if( pxRegisterBankOwner[ ucBank - 2 ] != NULL )
+		{
+			return pdFAIL;
+		}
+
+		pxRegisterBankOwner[ ucBank - 2 ] = ( tskTCB portOBJECT_SPACE * ) xTask;
+
+		/* The task has not run yet, so its stack holds just the frame built
+		by prvSetupInitialContext().  R0-R7 sit between B and PSW, and must
+		be taken out as they will no longer be popped off the stack.  Locate
+		the last byte of the frame - which depends on where the stack is. */
+		#if portNUM_STACK_SLOTS > 0
+			if( portGET_STACK_SLOT( xTask ) != portNO_STACK_SLOT )
+			{
+				pxFrameEnd = ( idata portSTACK_TYPE * ) ucSlotStackPointer[ portGET_STACK_SLOT( xTask ) ];
+				ucSlotStackPointer[ portGET_STACK_SLOT( xTask ) ] -= portREGISTER_BANK_SIZE;
+			}
+			else
+		#endif
+			{
+				pxStartOfStack = *( ( xdata portSTACK_TYPE ** ) xTask );
+				pxFrameEnd = pxStartOfStack + *pxStartOfStack;
+				*pxStartOfStack -= portREGISTER_BANK_SIZE;
+			}
+
+		/* Move PSW, BP, SPX (if used) and the critical nesting count down 
+		over the registers. */
+		for( pxFrameEnd -= portFRAME_TAIL_BYTES; ucTailByte <= portFRAME_TAIL_BYTES; ucTailByte++ )
+		{
+			*( pxFrameEnd - portREGISTER_BANK_SIZE ) = *pxFrameEnd;
+			pxFrameEnd++;
+		}
+
+		return pdPASS;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+unsigned portLONG ulPortGetSkippedStackCopies( void )
+{
+unsigned portLONG ulCount;
+
+	/* The count is updated from the tick interrupt so must be read within
+	a critical section. */
+	portENTER_CRITICAL();
+		ulCount = ulSkippedStackCopies;
+	portEXIT_CRITICAL();
+
+	return ulCount;
+}
+/*-----------------------------------------------------------*/
+
+#if USE_TRACE_FACILITY == 1
+
+	unsigned portLONG ulPortGetMaxTickClocks( void )
+	{
+	unsigned portSHORT usCounts;
+
+		/* Updated from the tick interrupt so read within a critical section. */
+		portENTER_CRITICAL();
+			usCounts = usMaxTickCounts;
+
+			#if portRECORD_FAST_TICK_DURATION == 1
+			{
+				if( ( unsigned portSHORT ) ( usMaxFastTickTimer - portTIMER_RELOAD_VALUE ) > usCounts )
+				{
+					usCounts = ( unsigned portSHORT ) ( usMaxFastTickTimer - portTIMER_RELOAD_VALUE );
+				}
+			}
+			#endif
+		portEXIT_CRITICAL();
+
+		return ( unsigned portLONG ) usCounts * ( unsigned portLONG ) portTICK_PRESCALER;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if portUSE_TICKLESS_IDLE == 1
+
+	void vPortSuppressTicksAndSleep( void )
+	{
+	unsigned portCHAR ucOriginalSFRPage, ucEarlyClocks;
+	portTickType xExpectedIdleTime, xCompleteTicks;
+	unsigned portSHORT usCount, usSleepCounts;
+	unsigned portLONG ulClocksIntoTick, ulClocks;
+
+		/* Interrupts are disabled directly, rather than by entering a critical
+		section, as they are re-enabled by the instruction before the one that
+		places the CPU in idle mode. */
+		EA = 0;
+
+		ucOriginalSFRPage = SFRPAGE;
+		SFRPAGE = portTICK_SFR_PAGE;
+
+		/* The idle task decided to sleep with interrupts enabled, so check
+		again now nothing can change.  The expected idle time is zero if an
+		interrupt has readied a task, or a tick has been missed, since. */
+		xExpectedIdleTime = xTaskGetExpectedIdleTime();
+
+		if( ( portTICK_FLAG == 0 ) && ( xExpectedIdleTime >= portMIN_TICKLESS_IDLE_TIME ) )
+		{
+			/* If the timer cannot count the whole period then sleep for as 
+			long as it can, and sleep again once woken. */
+			if( xExpectedIdleTime > portMAX_SUPPRESSED_TICKS )
+			{
+				xExpectedIdleTime = portMAX_SUPPRESSED_TICKS;
+			}
+
+			/* Note how far through the current tick period the timer is, then
+			restart it from zero clocked by the sleep prescaler, as the tick
+			prescaler might not be able to count even two tick periods.  The
+			timer is only stopped for the few instructions this takes, so the
+			tick drifts by no more than a few counts.  The sleep is calculated
+			while the timer runs. */
+			portTICK_RUN = 0;
+			usCount = ( ( unsigned portSHORT ) portTICK_TMRH << 8 ) | ( unsigned portSHORT ) portTICK_TMRL;
+			portTICK_TMRCF = portSLEEP_CLOCK_MODE;
+			portTICK_TMRL = ( unsigned portCHAR ) 0;
+			portTICK_TMRH = ( unsigned portCHAR ) 0;
+			portTICK_RUN = 1;
+
+			/* The clocks from the start of the current tick period to the 
+			restart, including those carried from the last sleep, and from the
+			restart to the end of the expected idle time. */
+			ulClocksIntoTick = ( ( unsigned portLONG ) ( unsigned portSHORT ) ( usCount - portTIMER_RELOAD_VALUE ) * ( unsigned portLONG ) portTICK_PRESCALER ) + ( unsigned portLONG ) ucCarriedClocks;
+			ulClocks = ( ( unsigned portLONG ) xExpectedIdleTime * ( unsigned portLONG ) portTICK_CLOCKS ) - ulClocksIntoTick;
+
+			/* The sleep prescaler does not generally divide a tick period 
+			exactly, so the timer overflows up to portSLEEP_PRESCALER - 1 
+			clocks before the sleep ends.  This is made up when the timer is
+			restored.  The reload value is left alone - the timer reloads for a
+			normal tick period when the sleep completes. */
+			usSleepCounts = ( unsigned portSHORT ) ( ulClocks / ( unsigned portLONG ) portSLEEP_PRESCALER );
+			ucEarlyClocks = ( unsigned portCHAR ) ( ulClocks % ( unsigned portLONG ) portSLEEP_PRESCALER );
+			if( usSleepCounts == ( unsigned portSHORT ) 0 )
+			{
+				usSleepCounts = ( unsigned portSHORT ) 1;
+				ucEarlyClocks = ( unsigned portCHAR ) 0;
+			}
+
+			ucTickDuringSleep = pdFALSE;
+			prvAdvanceTickTimer( ( unsigned portSHORT ) 0 - usSleepCounts );
+
+			/* The instruction that follows a write to IE is always executed
+			before an interrupt is serviced, so an interrupt cannot occur
+			between enabling interrupts and entering idle mode - which would
+			leave the CPU asleep until the next interrupt. */
+			_asm
+				setb	_EA
+				orl		_PCON,#0x01
+			_endasm;
+
+			/* Woken by an interrupt, which has now been serviced.  Restore the
+			tick prescaler, restarting the timer from the start of a tick 
+			period while the position within the period is calculated. */
+			EA = 0;
+			SFRPAGE = portTICK_SFR_PAGE;
+			portTICK_RUN = 0;
+			usCount = ( ( unsigned portSHORT ) portTICK_TMRH << 8 ) | ( unsigned portSHORT ) portTICK_TMRL;
+			portTICK_TMRCF = portTICK_CLOCK_MODE;
+			portTICK_TMRL = ( unsigned portCHAR ) ( portTIMER_RELOAD_VALUE & 0xff );
+			portTICK_TMRH = ( unsigned portCHAR ) ( portTIMER_RELOAD_VALUE >> 8 );
+			portTICK_RUN = 1;
+
+			if( ucTickDuringSleep || portTICK_FLAG )
+			{
+				/* The long period completed.  The tick ISR counts the last tick
+				of the period (if the flag is set it will do so once interrupts are
+				enabled again) as a missed tick, as the scheduler is suspended,
+				so only the remaining ticks need adding.  The timer has counted
+				from the reload value since the overflow, which came 
+				ucEarlyClocks before the tick period actually started. */
+				vTaskStepTick( xExpectedIdleTime - ( portTickType ) 1 );
+
+				ulClocks = ( unsigned portLONG ) ( unsigned portSHORT ) ( usCount - portTIMER_RELOAD_VALUE ) * ( unsigned portLONG ) portSLEEP_PRESCALER;
+				if( ulClocks > ( unsigned portLONG ) ucEarlyClocks )
+				{
+					ulClocks -= ( unsigned portLONG ) ucEarlyClocks;
+				}
+				else
+				{
+					ulClocks = ( unsigned portLONG ) 0;
+				}
+			}
+			else
+			{
+				/* Woken early by some other interrupt.  The timer had counted
+				from zero, less usSleepCounts, when it was stopped.  Account 
+				for the whole tick periods that have elapsed. */
+				ulClocks = ulClocksIntoTick + ( ( unsigned portLONG ) ( unsigned portSHORT ) ( usCount + usSleepCounts ) * ( unsigned portLONG ) portSLEEP_PRESCALER );
+				xCompleteTicks = ( portTickType ) ( ulClocks / ( unsigned portLONG ) portTICK_CLOCKS );
+				vTaskStepTick( xCompleteTicks );
+				ulClocks %= ( unsigned portLONG ) portTICK_CLOCKS;
+			}
+
+			/* Move the timer on to the current position within the tick 
+			period.  Any part of a count is carried into the next sleep. */
+			ucCarriedClocks = ( unsigned portCHAR ) ( ulClocks % ( unsigned portLONG ) portTICK_PRESCALER );
+			prvAdvanceTickTimer( ( unsigned portSHORT ) ( ulClocks / ( unsigned portLONG ) portTICK_PRESCALER ) );
+		}
+
+		SFRPAGE = ucOriginalSFRPage;
+		EA = 1;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvAdvanceTickTimer( unsigned portSHORT usCounts )
+	{
+	unsigned portSHORT usCount;
+
+		/* Called with interrupts disabled and the tick timer SFR page 
+		selected. */
+		portTICK_RUN = 0;
+		usCount = ( ( unsigned portSHORT ) portTICK_TMRH << 8 ) | ( unsigned portSHORT ) portTICK_TMRL;
+		usCount += usCounts;
+		if( usCount < usCounts )
+		{
+			usCount = ( unsigned portSHORT ) 0xffff;
+		}
+		portTICK_TMRL = ( unsigned portCHAR ) ( usCount & ( unsigned portSHORT ) 0xff );
+		portTICK_TMRH = ( unsigned portCHAR ) ( usCount >> 8 );
+		portTICK_RUN = 1;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if USE_TRACE_FACILITY == 1
+
+	unsigned portSHORT usPortCheckFreeStackSpace( const unsigned portCHAR *pucStackByte, unsigned portCHAR ucStackFillByte )
+	{
+	unsigned portSHORT usFreeBytes = ( unsigned portSHORT ) 0;
+
+		/* The stack grows upwards so pucStackByte points to the last byte of 
+		the XRAM stack, and the scan works back towards the start.  Only the
+		bytes that were in use when the task was switched out are ever copied
+		to XRAM, so those beyond the deepest switch still hold the fill byte.  
+		The context written when the task was created ends the scan. */
+		while( *pucStackByte == ucStackFillByte )
+		{
+			pucStackByte--;
+			usFreeBytes++;
+		}
+
+		return usFreeBytes;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
 /*
  * Manual context switch.  The first thing we do is save the registers so we
- * can use a naked attribute.
+ * can use a naked attribute.  As this is a function call only a minimal 
+ * context is saved - see portSAVE_YIELD_CONTEXT().
  */
 void vPortYield( void ) _naked
 {
-	/* Save the execution context onto the stack, then copy the entire stack
-	to XRAM.  This is necessary as the internal RAM is only large enough to
-	hold one stack, and we want one per task. 
-	
-	PERFORMANCE COULD BE IMPROVED BY ONLY COPYING TO XRAM IF A TASK SWITCH
-	IS REQUIRED. */
-	portSAVE_CONTEXT();
-	portCOPY_STACK_TO_XRAM();
-
-	/* Call the standard scheduler context switch function. */
+	/* Save the context that a function call must preserve onto the stack and
+	remember which task owns it.  A task is only switched out here when it 
+	calls portYIELD(), which must never be called from an ISR. */
+	portSAVE_YIELD_CONTEXT();
+	pxOutgoingTCB = pxCurrentTCB;
+
+	/* Call the standard scheduler context switch function.  This runs on the
+	stack of the task being switched out, above the saved context. */
 	vTaskSwitchContext();
 
-	/* Copy the stack of the task about to execute from XRAM into RAM and
-	restore it's context ready to run on exiting. */
-	portCOPY_XRAM_TO_STACK();
+	/* If a different task was selected then copy the entire stack to XRAM,
+	and the stack of the task about to execute from XRAM into RAM.  This is
+	necessary as the internal RAM is only large enough to hold one stack, and 
+	we want one per task.  Finally restore the context ready to run on 
+	exiting. */
+	portSWITCH_STACKS();
 	portRESTORE_CONTEXT();
 }
 /*-----------------------------------------------------------*/
 
-#if portUSE_PREEMPTION == 1
-	void vTimer2ISR( void ) interrupt 5 _naked
+#if ( portUSE_PREEMPTION == 1 ) && ( portUSE_TICK_FAST_PATH == 1 ) && ( USE_16_BIT_TICKS == 1 ) && ( portTICK_AUTO_RELOAD == 1 )
+	void vPortTickISR( void ) interrupt portTICK_VECTOR _naked
+	{
+		/* Two stage tick ISR.  Most ticks neither wake a delayed task nor
+		require a time slice, so the first stage saves only the registers it
+		needs, increments the tick count and returns.
+		
+		The registers are pushed in the same order as portSAVE_CONTEXT() so
+		the second stage can complete the full context save when the tick 
+		count reaches (or has passed) xNextTaskUnblockTime, or the low byte of
+		the tick count is about to wrap. */
+		_asm
+			push	ACC
+			push	IE
+			push	DPL
+			push	DPH
+			push	b
+
+			/* Calculate the new low byte of the tick count.  Leave any carry
+			into the high byte to the kernel. */
+			mov		dptr,#_xTickCount
+			movx	a,@dptr
+			inc		a
+			jz		0090$
+			mov		b,a
+
+			/* Subtract the new tick count from xNextTaskUnblockTime, low byte
+			first.  The kernel is entered if the result is zero, or has the 
+			top bit set as the wake time has already been passed.  The 
+			subtraction alters the flags so PSW is saved around it, and F0 
+			records whether the low byte of the result is zero as B is needed
+			for the high byte. */
+			push	PSW
+			mov		dptr,#_xNextTaskUnblockTime
+			movx	a,@dptr
+			clr		c
+			subb	a,b
+			clr		PSW.5
+			jnz		0078$
+			setb	PSW.5
+		0078$:
+			mov		dptr,#(_xTickCount + 1)
+			movx	a,@dptr
+			mov		b,a
+			mov		dptr,#(_xNextTaskUnblockTime + 1)
+			movx	a,@dptr
+			subb	a,b
+			jb		ACC.7,0079$
+			jnz		0091$
+			jnb		PSW.5,0091$
+
+		0079$:
+			/* Due.  Restore PSW and continue with the second stage. */
+			pop		PSW
+			sjmp	0090$
+
+		0091$:
+			/* Nothing for the kernel to do.  Store the new low byte of the 
+			tick count, clear the interrupt and restore the registers saved 
+			above.  IE was not modified so is discarded rather than popped. */
+			mov		dptr,#_xTickCount
+			movx	a,@dptr
+			inc		a
+			movx	@dptr,a
+			clr		portTICK_FLAG_ASM
+		_endasm;
+
+		#if portRECORD_FAST_TICK_DURATION == 1
+		{
+			/* Record the tick timer value if it is the highest seen, so the
+			time taken by ticks that do not call the kernel is included in 
+			ulPortGetMaxTickClocks().  R0 is saved for use along with B.  The 
+			high byte is read again in case the low byte overflowed into it. */
+			_asm
+				push	ar0
+			0076$:
+				mov		r0,portTICK_TMRH_ASM
+				mov		b,portTICK_TMRL_ASM
+				mov		a,portTICK_TMRH_ASM
+				xrl		a,r0
+				jnz		0076$
+				mov		dptr,#_usMaxFastTickTimer
+				movx	a,@dptr
+				clr		c
+				subb	a,b
+				inc		dptr
+				movx	a,@dptr
+				subb	a,r0
+				jnc		0077$
+				mov		a,r0
+				movx	@dptr,a
+				mov		dptr,#_usMaxFastTickTimer
+				mov		a,b
+				movx	@dptr,a
+			0077$:
+				pop		ar0
+			_endasm;
+		}
+		#endif
+
+		_asm
+			pop		PSW
+			pop		b
+			pop		DPH
+			pop		DPL
+			dec		SP
+			pop		ACC
+			reti
+
+		0090$:
+		_endasm;
+
+		/* Second stage.  Disable interrupts as per portSAVE_CONTEXT() and
+		save the remainder of the context. */
+		portDISABLE_FOR_CONTEXT_SWITCH();
+		portSAVE_REMAINING_CONTEXT();
+		pxOutgoingTCB = pxCurrentTCB;
+
+		portRECORD_TICK();
+		vTaskIncrementTick();
+		vTaskSwitchContext();
+		
+		portACKNOWLEDGE_TICK_INTERRUPT();
+		portSWITCH_STACKS();
+		portRECORD_TICK_DURATION();
+		portRESTORE_CONTEXT();
+	}
+#elif portUSE_PREEMPTION == 1
+	void vPortTickISR( void ) interrupt portTICK_VECTOR _naked
 	{
-		/* Preemptive context switch function triggered by the timer 2 ISR.
+		/* Preemptive context switch function triggered by the tick ISR.
 		This does the same as vPortYield() (see above) with the addition
 		of incrementing the RTOS tick count. */
 
 		portSAVE_CONTEXT();
-		portCOPY_STACK_TO_XRAM();
+		pxOutgoingTCB = pxCurrentTCB;
 
+		portRECORD_TICK();
 		vTaskIncrementTick();
 		vTaskSwitchContext();
 		
-		portCLEAR_INTERRUPT_FLAG();
-		portCOPY_XRAM_TO_STACK();
+		portACKNOWLEDGE_TICK_INTERRUPT();
+		portSWITCH_STACKS();
+		portRECORD_TICK_DURATION();
 		portRESTORE_CONTEXT();
 	}
-#else
-	void vTimer2ISR( void ) interrupt 5
+#endif
+/*-----------------------------------------------------------*/
+
+#if portUSE_PREEMPTION == 1
+	void vTimer3ISR( void ) interrupt 14 _naked
 	{
-		/* When using the cooperative scheduler the timer 2 ISR is only 
+		/* Context switch requested by portYIELD_FROM_ISR().  The ISR that 
+		made the request has already exited, so only the context of the 
+		interrupted task is on the stack.  Any number of requests made 
+		before this runs result in a single switch. */
+		portSAVE_CONTEXT();
+		pxOutgoingTCB = pxCurrentTCB;
+
+		/* The request flag can only be accessed from SFR page 1.  The SFR 
+		page of the interrupted code is restored on exit. */
+		SFRPAGE = portYIELD_SFR_PAGE;
+		TF3 = 0;
+
+		vTaskSwitchContext();
+
+		portSWITCH_STACKS();
+		portRESTORE_CONTEXT();
+	}
+#endif
+/*-----------------------------------------------------------*/
+
+#if portUSE_PREEMPTION == 0
+	void vPortTickISR( void ) interrupt portTICK_VECTOR
+	{
+		/* When using the cooperative scheduler the tick ISR is only 
 		required to increment the RTOS tick count. */
 
+		portRECORD_TICK();
 		vTaskIncrementTick();
-		portCLEAR_INTERRUPT_FLAG();
+		portACKNOWLEDGE_TICK_INTERRUPT();
+		portRECORD_TICK_DURATION();
 	}
 #endif
 /*-----------------------------------------------------------*/
@@ -391,41 +1820,90 @@ static void prvSetupTimerInterrupt( void )
 {
 unsigned portCHAR ucOriginalSFRPage;
 
-/* Constants calculated to give the required timer capture values. */
-const unsigned portLONG ulTicksPerSecond = portCPU_CLOCK_HZ / portCLOCK_DIVISOR;
-const unsigned portLONG ulCaptureTime = ulTicksPerSecond / portTICK_RATE_HZ;
-const unsigned portLONG ulCaptureValue = portMAX_TIMER_VALUE - ulCaptureTime;
-const unsigned portCHAR ucLowCaptureByte = ( unsigned portCHAR ) ( ulCaptureValue & ( unsigned portLONG ) 0xff );
-const unsigned portCHAR ucHighCaptureByte = ( unsigned portCHAR ) ( ulCaptureValue >> ( unsigned portLONG ) 8 );
-
-	/* NOTE:  This uses a timer only present on 8052 architecture. */
-
 	/* Remember the current SFR page so we can restore it at the end of the
 	function. */
 	ucOriginalSFRPage = SFRPAGE;
-	SFRPAGE = 0;
+	SFRPAGE = portTICK_SFR_PAGE;
+
+	#if portTICK_AUTO_RELOAD == 1
+	{
+		/* Select the prescaler chosen for the tick rate. */
+		portTICK_TMRCF = portTICK_CLOCK_MODE;
+
+		/* Setup the overflow reload value. */
+		portTICK_RCAPL = ( unsigned portCHAR ) ( portTIMER_RELOAD_VALUE & 0xff );
+		portTICK_RCAPH = ( unsigned portCHAR ) ( portTIMER_RELOAD_VALUE >> 8 );
 
-	/* TMR2CF can be left in its default state. */	
-	TMR2CF = ( unsigned portCHAR ) 0;
+		/* The initial load is performed manually. */
+		portTICK_TMRL = ( unsigned portCHAR ) ( portTIMER_RELOAD_VALUE & 0xff );
+		portTICK_TMRH = ( unsigned portCHAR ) ( portTIMER_RELOAD_VALUE >> 8 );
 
-	/* Setup the overflow reload value. */
-	RCAP2L = ucLowCaptureByte;
-	RCAP2H = ucHighCaptureByte;
+		portENABLE_TICK_INTERRUPT();
 
-	/* The initial load is performed manually. */
-	TMR2L = ucLowCaptureByte;
-	TMR2H = ucHighCaptureByte;
+		/* Interrupts are disabled when this is called so the timer can be 
+		started here. */
+		portTICK_TMRCN = portENABLE_TIMER;
+	}
+	#elif portTICK_SOURCE == portTICK_SOURCE_PCA
+	{
+		/* The PCA counter runs freely from zero.  Module 0 generates an
+		interrupt each time the counter matches the compare value, which the
+		ISR then moves on by one tick period. */
+		CR = 0;
+		PCA0MD = portTICK_CLOCK_MODE;
+		PCA0L = ( unsigned portCHAR ) 0;
+		PCA0H = ( unsigned portCHAR ) 0;
+
+		usNextTickCompare = ( unsigned portSHORT ) portTICK_COUNTS;
+		PCA0CPL0 = ( unsigned portCHAR ) ( usNextTickCompare & 0xff );
+		PCA0CPH0 = ( unsigned portCHAR ) ( usNextTickCompare >> 8 );
+		PCA0CPM0 = portPCA_SOFTWARE_TIMER;
+
+		EIE1 |= portPCA_INTERRUPT_ENABLE;
+		CR = 1;
+	}
+	#elif portTICK_SOURCE == portTICK_SOURCE_TIMER_0
+	{
+		/* 16 bit mode clocked from SYSCLK.  The timer 1 settings are left
+		unchanged. */
+		TMOD = ( TMOD & ~portTIMER_0_MODE_MASK ) | portTIMER_0_16_BIT_MODE;
+		CKCON |= portTICK_CLOCK_MODE;
 
-	/* Enable the timer 2 interrupts. */
-	IE |= portTIMER_2_INTERRUPT_ENABLE;
+		TL0 = ( unsigned portCHAR ) ( portTIMER_RELOAD_VALUE & 0xff );
+		TH0 = ( unsigned portCHAR ) ( portTIMER_RELOAD_VALUE >> 8 );
 
-	/* Interrupts are disabled when this is called so the timer can be started
-	here. */
-	TMR2CN = portENABLE_TIMER;
+		ET0 = 1;
+		TR0 = 1;
+	}
+	#endif
 
 	/* Restore the original SFR page. */
 	SFRPAGE = ucOriginalSFRPage;
 }
+/*-----------------------------------------------------------*/
+
+#if portUSE_PREEMPTION == 1
+
+	static void prvSetupYieldInterrupt( void )
+	{
+	unsigned portCHAR ucOriginalSFRPage;
+
+		ucOriginalSFRPage = SFRPAGE;
+		SFRPAGE = portYIELD_SFR_PAGE;
+
+		/* Timer 3 is left stopped - the interrupt is only ever generated by 
+		portYIELD_FROM_ISR() setting TF3. */
+		TMR3CN = ( unsigned portCHAR ) 0;
+
+		/* Enable the interrupt at the default low priority, the same as that 
+		of the ISRs that can request a switch. */
+		EIP2 &= ~portTIMER_3_HIGH_PRIORITY;
+		EIE2 |= portTIMER_3_INTERRUPT_ENABLE;
+
+		SFRPAGE = ucOriginalSFRPage;
+	}
+
+#endif
 
 
 
@@ -42,30 +42,36 @@
 #define heapSMALL_BLOCK_SIZE		( ( unsigned portSHORT ) 54 )
 #define heapLARGE_BLOCK_SIZE		portMINIMAL_STACK_SIZE
 
+/* The port copies task stacks to and from XRAM using MOVX @Ri, which cannot
+cross a 256 byte page boundary.  Each page therefore holds one large block
+followed by one small block, and the remaining small blocks are packed four 
+to a page. */
+#define heapPAGE_SIZE				( ( unsigned portSHORT ) 256 )
+#define heapSMALL_BLOCKS_PER_PAGE	( 4 )
+
 /* The number of each block size allocated. */
 #define heapNUM_SMALL_BLOCKS		( 40 )
-#define heapNUM_LARGE_BLOCKS		( 30 )
+#define heapNUM_LARGE_BLOCKS		( 24 )
 
-/* Each block contains the data area and a variable that marks the block as
-empty of full. */
-typedef struct
-{
-	unsigned portCHAR ucFull;
-	unsigned portCHAR ucBlock[ heapSMALL_BLOCK_SIZE ];
-} xSmallBlock;
+#define heapNUM_SMALL_ONLY_PAGES	( ( ( heapNUM_SMALL_BLOCKS - heapNUM_LARGE_BLOCKS ) + ( heapSMALL_BLOCKS_PER_PAGE - 1 ) ) / heapSMALL_BLOCKS_PER_PAGE )
+#define heapNUM_PAGES				( heapNUM_LARGE_BLOCKS + heapNUM_SMALL_ONLY_PAGES )
 
-typedef struct
-{
-	unsigned portCHAR ucFull;
-	unsigned portCHAR ucBlock[ heapLARGE_BLOCK_SIZE ];
-} xLargeBlock;
+/* The actual block allocation.  One extra page is allocated so the first 
+page can be aligned to a page boundary at run time. */
+xdata static unsigned portCHAR ucHeap[ ( heapNUM_PAGES + 1 ) * heapPAGE_SIZE ];
+static unsigned portCHAR * xdata pucAlignedHeap = NULL;
 
-/* The actual block allocation. */
-static xSmallBlock xSmallBlocks[ heapNUM_SMALL_BLOCKS ];
-static xLargeBlock xLargeBlocks[ heapNUM_LARGE_BLOCKS ];
+/* Marks each block as empty or full. */
+xdata static unsigned portCHAR ucSmallBlockFull[ heapNUM_SMALL_BLOCKS ];
+xdata static unsigned portCHAR ucLargeBlockFull[ heapNUM_LARGE_BLOCKS ];
 
-static volatile unsigned portCHAR ucSmall = 0;
-static volatile unsigned portCHAR ucLarge = 0;
+xdata static volatile unsigned portCHAR ucSmall = 0;
+xdata static volatile unsigned portCHAR ucLarge = 0;
+
+/*
+ * Returns the address of a small block within the aligned heap.
+ */
+static void *prvSmallBlockAddress( unsigned portCHAR ucBlock );
 
 /*-----------------------------------------------------------*/
 void *pvPortMalloc( unsigned portSHORT usSize )
@@ -75,15 +81,20 @@ unsigned portCHAR ucBlock;
 
 	portENTER_CRITICAL();
 	{
+		if( pucAlignedHeap == NULL )
+		{
+			pucAlignedHeap = ( xdata unsigned portCHAR * ) ( ( ( unsigned portSHORT ) ucHeap + ( heapPAGE_SIZE - 1 ) ) & ~( heapPAGE_SIZE - 1 ) );
+		}
+
 		if( usSize <= heapSMALL_BLOCK_SIZE )
 		{
 			/* Try to find a block in the list of small blocks. */
 			for( ucBlock = 0; ucBlock < heapNUM_SMALL_BLOCKS; ucBlock++ )
 			{
-				if( xSmallBlocks[ ucBlock ].ucFull == pdFALSE )
+				if( ucSmallBlockFull[ ucBlock ] == pdFALSE )
 				{
-					xSmallBlocks[ ucBlock ].ucFull = pdTRUE;
-					pv = ( void * ) ( xSmallBlocks[ ucBlock ].ucBlock );
+					ucSmallBlockFull[ ucBlock ] = pdTRUE;
+					pv = prvSmallBlockAddress( ucBlock );
 					ucSmall++;
 					break;
 				}
@@ -97,10 +108,12 @@ unsigned portCHAR ucBlock;
 		{		
 			for( ucBlock = 0; ucBlock < heapNUM_LARGE_BLOCKS; ucBlock++ )
 			{	
-				if( xLargeBlocks[ ucBlock ].ucFull == pdFALSE )
+				if( ucLargeBlockFull[ ucBlock ] == pdFALSE )
 				{
-					xLargeBlocks[ ucBlock ].ucFull = pdTRUE;
-					pv = ( void * ) ( xLargeBlocks[ ucBlock ].ucBlock );
+					ucLargeBlockFull[ ucBlock ] = pdTRUE;
+
+					/* Large blocks start each page. */
+					pv = ( void * ) ( pucAlignedHeap + ( ucBlock * heapPAGE_SIZE ) );
 					ucLarge++;
 					break;
 				}
@@ -119,6 +132,25 @@ unsigned portCHAR ucBlock;
 }
 /*-----------------------------------------------------------*/
 
+static void *prvSmallBlockAddress( unsigned portCHAR ucBlock )
+{
+unsigned portSHORT usOffset;
+
+	if( ucBlock < heapNUM_LARGE_BLOCKS )
+	{
+		/* The block follows the large block in the same page. */
+		usOffset = ( ucBlock * heapPAGE_SIZE ) + heapLARGE_BLOCK_SIZE;
+	}
+	else
+	{
+		ucBlock -= heapNUM_LARGE_BLOCKS;
+		usOffset = ( ( heapNUM_LARGE_BLOCKS + ( ucBlock / heapSMALL_BLOCKS_PER_PAGE ) ) * heapPAGE_SIZE ) + ( ( ucBlock % heapSMALL_BLOCKS_PER_PAGE ) * heapSMALL_BLOCK_SIZE );
+	}
+
+	return ( void * ) ( pucAlignedHeap + usOffset );
+}
+/*-----------------------------------------------------------*/
+
 void vPortFree( void *pv )
 {
 	/* The AVR demo application does not use any calls to free(). */
@@ -41,14 +41,88 @@ supplied with the distribution. */
  * Port specific definitions for the Cygnal 8051 port.
  *----------------------------------------------------------*/
 
-/* THE VALUE FOR portSTACK_START MUST BE OBTAINED FROM THE .MEM FILE. */
-#define portSTACK_START			( 0x0e )
+/* 
+ * Set portUSE_TASK_REGISTER_BANKS to 1 to allow up to two tasks to keep R0-R7
+ * in register banks 2 and 3 while they are not running, in place of saving 
+ * them on the stack as part of the context.  The tasks are selected by calling
+ * sPortSetTaskRegisterBank().  
+ *
+ * All code still executes in bank 0 as SDCC generates code that accesses R0-R7
+ * by their bank 0 address.  Banks 2 and 3 are therefore not available to 
+ * interrupts that use the 'using' keyword when this is set to 1.
+ */
+#define portUSE_TASK_REGISTER_BANKS		0
+#define portNUM_TASK_REGISTER_BANKS		2
+#define portREGISTER_BANK_SIZE			8
+#define portREGISTER_BANK_TOP( ucBank )	( ( unsigned portCHAR ) ( ( ( ucBank ) * portREGISTER_BANK_SIZE ) + ( portREGISTER_BANK_SIZE - 1 ) ) )
+
+/* 
+ * portSTACK_START is the idata address of the first byte of the stack.  It is
+ * taken from __start__stack, which the linker places above all the data and
+ * idata variables - including register banks 2 and 3 when they are reserved 
+ * by portUSE_TASK_REGISTER_BANKS - and from which the startup code sets SP.
+ * It therefore follows any variable placed in data memory under any model, 
+ * and does not need to be read from the .mem file.
+ */
+#define portSTACK_START				( ( unsigned portCHAR ) _start__stack )
 
 #define portUSE_PREEMPTION		1
-#define portCPU_CLOCK_HZ		( ( unsigned portLONG ) 98000000 )
-#define portTICK_RATE_HZ		( ( portTickType ) 1000 )
-#define portMAX_PRIORITIES		( ( unsigned portSHORT ) 4 )
-#define portMINIMAL_STACK_SIZE	( ( unsigned portSHORT ) 200 - ( unsigned portSHORT ) portSTACK_START )
+
+/* A plain number as the size of the ready priority bitmap is calculated from 
+it by the preprocessor. */
+#define portMAX_PRIORITIES		4
+
+/* The clock and tick rate are plain numbers as the tick timer settings are
+calculated from them by the preprocessor. */
+#define portCPU_CLOCK			98000000
+#define portTICK_RATE			1000
+#define portCPU_CLOCK_HZ		( ( unsigned portLONG ) portCPU_CLOCK )
+#define portTICK_RATE_HZ		( ( portTickType ) portTICK_RATE )
+
+/* 
+ * The peripheral used to generate the tick.  Timers 2, 3 and 4 use 16 bit 
+ * auto-reload, timer 0 is reloaded by the tick ISR and the PCA uses module 0 
+ * as a software timer.  The timer prescaler is chosen at compile time, and 
+ * compilation fails if the tick rate cannot be generated exactly from 
+ * portCPU_CLOCK.  Timer 0 must be clocked directly from SYSCLK to be reloaded
+ * without drift, so needs a tick rate of at least portCPU_CLOCK / 65535.  
+ * Timer 3 generates the interrupt used by portYIELD_FROM_ISR() so can only 
+ * be used with the cooperative scheduler.
+ */
+#define portTICK_SOURCE_TIMER_0		0
+#define portTICK_SOURCE_TIMER_2		2
+#define portTICK_SOURCE_TIMER_3		3
+#define portTICK_SOURCE_TIMER_4		4
+#define portTICK_SOURCE_PCA			5
+
+#define portTICK_SOURCE				portTICK_SOURCE_TIMER_2
+
+/* 
+ * Tasks created using sTaskCreateResident() are given a fixed slot of idata
+ * at the top of internal RAM for their stack.  Their stack is never copied to
+ * or from XRAM - switching such a task in or out only changes SP.  Slots are
+ * taken from the top of idata downwards, and the stack of all the other tasks
+ * must fit in the space between portSTACK_START and the lowest slot.  Each 
+ * slot must be large enough to hold the task's own stack usage, plus the 
+ * context saved by the tick ISR, plus the stack used by the kernel when 
+ * switching context.  
+ *
+ * Set portNUM_STACK_SLOTS to 0 to exclude the feature.  The idle task can be
+ * placed in a slot by setting portIDLE_TASK_STACK_SLOT to the slot index.
+ * The cycles saved over the copy path have not yet been measured under s51,
+ * so the feature is excluded by default.
+ */
+#define portNUM_STACK_SLOTS			0
+#define portSTACK_SLOT_SIZE			56
+#define portSTACK_SLOT_START		( 0x100 - ( portNUM_STACK_SLOTS * portSTACK_SLOT_SIZE ) )
+#define portNO_STACK_SLOT			0xff
+#define portIDLE_TASK_STACK_SLOT	portNO_STACK_SLOT
+
+#if portNUM_STACK_SLOTS > 0
+	#define portMINIMAL_STACK_SIZE	( ( unsigned portSHORT ) portSTACK_SLOT_START - ( unsigned portSHORT ) portSTACK_START )
+#else
+	#define portMINIMAL_STACK_SIZE	( ( unsigned portSHORT ) 200 - ( unsigned portSHORT ) portSTACK_START )
+#endif
 
 /* Set the following definitions to 1 to include the component, or zero
 to exclude the component. */
@@ -59,10 +133,213 @@ to exclude the component. */
 #define INCLUDE_vTaskDelete				0
 #define INCLUDE_vTaskCleanUpResources	0
 #define INCLUDE_vTaskSuspend			0
+#define INCLUDE_cTaskDelayUntil			1
 
 /* Use/don't use the trace visualisation. */
 #define USE_TRACE_FACILITY				0
 
+/* Set to 1 to include the software timers (timers.c).  A single timer task
+calls the callback function of each timer as it expires, in place of a task
+per periodic job.  The timer task is created by vTaskStartScheduler().  
+Commands sent before the scheduler is started are only processed once the 
+timer task runs, so portTIMER_QUEUE_LENGTH must be at least the number of 
+commands sent before then - eight by the LED flash timers of the demo. */
+#define USE_TIMERS						1
+#define portTIMER_TASK_PRIORITY			( portMAX_PRIORITIES - ( unsigned portCHAR ) 1 )
+#define portTIMER_TASK_STACK_SIZE		portMINIMAL_STACK_SIZE
+#define portTIMER_QUEUE_LENGTH			8
+
+/* Set to 1 to include the co-routines (croutine.c).  Co-routines have no 
+stack of their own - they all run on the stack of the idle task, which calls
+vCoRoutineSchedule() each time round its loop - so cost a few bytes of RAM 
+each and are switched without copying any stack.  Co-routines only run when
+no task above the idle priority is ready. */
+#define USE_CO_ROUTINES					0
+#define portMAX_CO_ROUTINE_PRIORITIES	2
+
+/* Set to 1 to give each task a 32 bit notification value that other tasks and
+ISRs can send to directly (cTaskNotify()), in place of a queue or semaphore.
+Adds five bytes to each TCB, so is off unless the application uses it. */
+#define USE_TASK_NOTIFICATIONS			0
+
+/* Set to 1 to include the event groups (event_groups.c).  portMAX_EVENT_GROUPS
+groups, of eight event bits each, are declared statically rather than taken 
+from the heap, so may be no more than 8.  The event bits are read on every 
+call that tests them so are placed in data memory under every model, which 
+moves the start of the stack up by portMAX_EVENT_GROUPS bytes. */
+#define USE_EVENT_GROUPS				0
+#define portMAX_EVENT_GROUPS			4
+#define portEVENT_BITS_DATA				data
+
+/* Set to 1 to find the highest priority ready task in constant time using a
+bitmap of the ready priorities and lookup tables in code memory.  This allows
+portMAX_PRIORITIES to be up to 16 without slowing the context switch. */
+#define USE_PRIORITY_BITMAP				1
+
+/* Set to 1 to hold delayed and blocked tasks in a hashed timing wheel of
+portTIMING_WHEEL_SLOTS unsorted lists, indexed by wake time, in place of a list
+sorted by wake time.  A task then blocks in constant time however many tasks
+are already blocked, and the tick only examines the tasks that share the slot
+of the current tick.  Each slot costs one xList of RAM.  portTIMING_WHEEL_SLOTS
+must be a power of 2 no greater than 128 - ideally no fewer than the number of
+tasks that are normally blocked at once. */
+#define USE_TIMING_WHEEL				0
+#define portTIMING_WHEEL_SLOTS			8
+
+/* Set to 1 to count the number of times the 16 bit tick count has wrapped
+(the tick epoch).  vTaskDelayLong() can then delay a task for up to 2^32 ticks
+while the delayed lists and the tick ISR continue to use 16 bit tick values.
+A task delayed beyond the current epoch waits on a list of its own that is 
+only inspected when the tick count wraps.  Requires USE_16_BIT_TICKS. */
+#define USE_TICK_EPOCH					0
+
+/* The most delayed tasks the tick interrupt will make ready in one tick, or 0
+for no limit.  Should more tasks than this be due at once the others are made
+ready by the ticks that follow, so the time spent in the tick interrupt is
+bounded at the cost of some tasks waking a tick or two late.  Ticks processed
+by cTaskResumeAll() are not limited. */
+#define portMAX_TASKS_WOKEN_PER_TICK	0
+
+/* Set to 1 to copy task stacks to and from XRAM using MOVX @Ri.  This
+requires the memory allocator to place each task stack within a single 256 
+byte XRAM page, as the allocator in portheap.c does.  EMI0CN selects the page
+of the stack being copied, so any interrupt that can run during the copies 
+must not use MOVX @Ri or pdata (see portUSE_KERNEL_INTERRUPT_MASKING).  The 
+copy loops have not yet been assembled, nor their cycle count compared with
+the C copy under s51, so the C copy remains the default. */
+#define portUSE_PAGED_STACK_COPY		0
+
+/*
+ * Set portUSE_EXTERNAL_STACK to 1 when building with the SDCC --xstack option
+ * (all files, and a library built with --xstack).  Locals and parameters are
+ * then held on a stack in pdata, leaving only return addresses and the saved
+ * context in idata - so much less is copied on each context switch.
+ *
+ * Each task has its own external stack within its 256 byte XRAM stack page
+ * (see portheap.c).  The first portIDATA_IMAGE_SIZE bytes of the stack 
+ * allocated to the task hold the copy of its idata stack, including the size
+ * byte, and the remainder is its external stack.  EMI0CN selects the page of
+ * the running task and _spx forms part of the task context.  
+ *
+ * Tasks created with sTaskCreateResident() have no XRAM stack, so 
+ * portNUM_STACK_SLOTS must be 0.  When portUSE_KERNEL_INTERRUPT_MASKING is 1
+ * high priority interrupts must not use the external stack, as they can 
+ * execute while EMI0CN and _spx are being changed.
+ */
+#define portUSE_EXTERNAL_STACK			0
+#define portIDATA_IMAGE_SIZE			48
+
+/*
+ * The kernel, port and demo can be built with --model-small or --model-medium
+ * as well as --model-large.  The kernel lists, tick count and the other kernel
+ * variables are always placed in XRAM (portKERNEL_DATA) as there is not 
+ * enough data memory for them.  xTickCount and xNextTaskUnblockTime must 
+ * remain in XRAM as the tick ISR accesses them using MOVX.  
+ *
+ * The variables read on every context switch - pxCurrentTCB, 
+ * ucTopReadyPriority and ucSchedulerSuspended - are placed in data memory 
+ * (portKERNEL_HOT_DATA) under the small and medium models.  They remain in 
+ * XRAM under the large model to leave the idata for the stack, but can be 
+ * moved by defining portKERNEL_HOT_DATA as data here.  portSTACK_START 
+ * follows them either way.
+ *
+ * Under the medium model unqualified variables are placed in pdata, which is
+ * addressed through EMI0CN, so the model cannot be used with 
+ * portUSE_EXTERNAL_STACK.  Task stacks, TCBs and queues are always allocated
+ * from the XRAM heap in portheap.c - they are not placed in a pdata page 
+ * under any model.
+ *
+ * Support for the small and medium models is limited to the memory space
+ * qualifiers above.  Neither model has yet been compiled, nor their code 
+ * size and cycle counts compared with the large model.  Note that 
+ * portMINIMAL_STACK_SIZE is calculated at run time from portSTACK_START.
+ */
+#if defined( SDCC_MODEL_SMALL ) || defined( SDCC_MODEL_MEDIUM )
+	#define portKERNEL_HOT_DATA			data
+#else
+	#define portKERNEL_HOT_DATA
+#endif
+#define portKERNEL_DATA					xdata
+
+/*
+ * Set portXRAM_ONLY_OBJECTS to 1 to have the pointers within list items, 
+ * lists, TCBs and queues, and the task and queue handles, declared as 2 byte
+ * xdata pointers in place of 3 byte generic pointers.  Each list item is then
+ * 4 bytes smaller, and the list and queue code accesses the objects with 
+ * MOVX directly rather than through the generic pointer library routines.
+ *
+ * Every list, TCB, task stack and queue (including its storage area) must 
+ * then be in XRAM.  Those created by the kernel are allocated from the heap
+ * in portheap.c, so this only restricts lists declared by the application.
+ *
+ * This changes the width of every object pointer in the kernel, and has not
+ * yet been compiled by SDCC nor the cycles it saves in prvCheckDelayedTasks()
+ * and vTaskSwitchContext() measured, so is off by default.
+ */
+#define portXRAM_ONLY_OBJECTS			0
+
+#if portXRAM_ONLY_OBJECTS == 1
+	#define portOBJECT_SPACE			xdata
+#endif
+
+/* Constant tables used by the kernel are read using MOVC. */
+#define portCODE_SPACE					code
+
+/* 
+ * Set portUSE_KERNEL_INTERRUPT_MASKING to 1 to have critical sections and 
+ * context switches mask only the kernel aware interrupts, rather than 
+ * clearing EA.  Kernel aware interrupts are those that call the kernel - 
+ * their enable bits are listed in the masks below (IE, EIE1 and EIE2 
+ * respectively).  They are forced to low priority when the scheduler starts.
+ * Any other interrupt can be given high priority in IP/EIP1/EIP2 and will 
+ * then never be held off by the kernel.  
+ *
+ * High priority interrupts MUST NOT call any kernel function, including the 
+ * FromISR() queue functions and portYIELD_FROM_ISR().  They can occur during
+ * the stack copies of a context switch, so MUST NOT use MOVX @Ri or pdata 
+ * variables when portUSE_PAGED_STACK_COPY is 1 (the copies change EMI0CN),
+ * and their frame must fit in idata above the deepest task stack.  SP is set
+ * to the top of the incoming stack before it is copied in, so the frame is 
+ * never written over the stack being restored.
+ *
+ * The kernel aware interrupts must remain enabled once the scheduler has 
+ * started.  The timer 2 enable bit is used to indicate whether they are 
+ * currently masked so must always be included in portKERNEL_IE_MASK - even 
+ * if timer 2 is not the tick source, in which case its interrupt must either
+ * not be used or be kernel aware.  The enable bit of the tick source must be
+ * included in the masks.  The masks are used by the assembly code so must be
+ * plain numbers.
+ */
+#define portUSE_KERNEL_INTERRUPT_MASKING	0
+#define portKERNEL_IE_MASK					0x30	/* Timer 2 (tick) and UART 0. */
+#define portKERNEL_EIE1_MASK				0x00
+#define portKERNEL_EIE2_MASK				0x01	/* Timer 3 (portYIELD_FROM_ISR()). */
+
+/* Set to 1 to have the preemptive tick ISR only save the full context and
+call into the kernel when a delayed task is due to wake or time slicing is
+required.  Other ticks just increment the tick count.  Requires 16 bit ticks.
+The first stage of the ISR is hand written assembly that has yet to be 
+assembled by SDCC or run under s51, so the option is off by default until 
+the demo has been built and run with it. */
+#define portUSE_TICK_FAST_PATH			0
+
+/*
+ * Set portUSE_TICKLESS_IDLE to 1 to have the idle task stop the periodic tick
+ * and place the CPU in idle mode when no task is due to wake for at least
+ * portMIN_TICKLESS_IDLE_TIME ticks.  The tick timer is reprogrammed to 
+ * overflow when the first delayed task is due to wake, and the tick count is
+ * corrected when the CPU is woken.  The tick source must be timer 2, 3 or 4.
+ * The timer is clocked at SYSCLK / 12 while the CPU sleeps, whatever the 
+ * prescaler used for the tick, so a single sleep is limited to the number of
+ * whole tick periods the 16 bit timer can count at that rate (eight at 98MHz
+ * and 1kHz) - longer periods are made up of several sleeps.
+ *
+ * Off by default, as the drift of the tick count and the current saved have
+ * not yet been measured on hardware.
+ */
+#define portUSE_TICKLESS_IDLE			0
+#define portMIN_TICKLESS_IDLE_TIME		( ( portTickType ) 2 )
+
 /* 
  * The tick count (and times defined in tick count units) can be either a 16bit
  * or a 32 bit value.  See documentation on http://www.FreeRTOS.org to decide
@@ -93,21 +370,95 @@ to exclude the component. */
 
 /*-----------------------------------------------------------*/	
 
-#define portENTER_CRITICAL()		_asm		\
-									push	ACC	\
-									push	IE	\
-									_endasm;	\
-									EA = 0;
-
-#define portEXIT_CRITICAL()			_asm			\
-									pop		ACC		\
-									_endasm;		\
-									ACC &= 0x80;	\
-									IE |= ACC;		\
-									_asm			\
-									pop		ACC		\
-									_endasm;
+/* 
+ * Critical sections are tracked with a nesting count held in data memory, 
+ * rather than by pushing IE onto the stack.  The state of EA (or of the 
+ * kernel interrupt mask if portUSE_KERNEL_INTERRUPT_MASKING is 1) on entry to
+ * the outermost critical section is held in the top bit of the count, and is
+ * only restored when the count returns to zero.  A critical section can 
+ * therefore be exited in a different function to that in which it was 
+ * entered, and does not add to the stack that is copied on a context switch.
+ * The count forms part of the context of each task.  Bit 6 of the saved copy 
+ * marks the shorter frame saved by portYIELD(), so the count must not reach 
+ * 64.
+ *
+ * The count adds one byte to every saved context, where each critical section
+ * open at a context switch previously added two (ACC and IE).  This is taken
+ * from the code - the bytes copied per switch and the time spent with 
+ * interrupts disabled have not been measured.
+ */
+extern data unsigned portCHAR ucCriticalNesting;
+
+/* The start of the stack as placed by the linker - see portSTACK_START. */
+extern idata unsigned portCHAR _start__stack[];
+
+#define portNO_CRITICAL_NESTING		( ( unsigned portCHAR ) 0x00 )
+#define portCRITICAL_EA_BIT			( ( unsigned portCHAR ) 0x80 )
+
+#if portUSE_KERNEL_INTERRUPT_MASKING == 1
+
+	/* The kernel aware interrupts are masked as a group.  ET2 being set 
+	indicates that they are not currently masked.  IE is always written first
+	so an interrupt that occurs part way through sees the indicator already
+	changed.  The context switch code then completes the change when the 
+	interrupted task is resumed. */
+	#define portMASK_KERNEL_INTERRUPTS()										\
+	{																			\
+		IE &= ~portKERNEL_IE_MASK;												\
+		EIE1 &= ~portKERNEL_EIE1_MASK;											\
+		EIE2 &= ~portKERNEL_EIE2_MASK;											\
+	}
+
+	#define portUNMASK_KERNEL_INTERRUPTS()										\
+	{																			\
+		IE |= portKERNEL_IE_MASK;												\
+		EIE1 |= portKERNEL_EIE1_MASK;											\
+		EIE2 |= portKERNEL_EIE2_MASK;											\
+	}
+
+	#define portENTER_CRITICAL()												\
+	{																			\
+		if( ET2 )																\
+		{																		\
+			portMASK_KERNEL_INTERRUPTS();										\
+			ucCriticalNesting |= portCRITICAL_EA_BIT;							\
+		}																		\
+		ucCriticalNesting++;													\
+	}
+
+	#define portEXIT_CRITICAL()													\
+	{																			\
+		ucCriticalNesting--;													\
+		if( ucCriticalNesting == portCRITICAL_EA_BIT )							\
+		{																		\
+			ucCriticalNesting = portNO_CRITICAL_NESTING;						\
+			portUNMASK_KERNEL_INTERRUPTS();										\
+		}																		\
+	}
 
+#else
+
+	#define portENTER_CRITICAL()													\
+	{																				\
+		if( EA )																	\
+		{																			\
+			EA = 0;																	\
+			ucCriticalNesting |= portCRITICAL_EA_BIT;								\
+		}																			\
+		ucCriticalNesting++;														\
+	}
+
+	#define portEXIT_CRITICAL()														\
+	{																				\
+		ucCriticalNesting--;														\
+		if( ucCriticalNesting == portCRITICAL_EA_BIT )								\
+		{																			\
+			ucCriticalNesting = portNO_CRITICAL_NESTING;							\
+			EA = 1;																	\
+		}																			\
+	}
+
+#endif
 /*-----------------------------------------------------------*/
 
 #define portDISABLE_INTERRUPTS()	EA = 0;
@@ -128,12 +479,102 @@ to exclude the component. */
 void vPortYield( void ) _naked;
 #define portYIELD()	vPortYield();
 
+/*
+ * Request a context switch from within an ISR.  The ISR must not call 
+ * portYIELD() itself.  The switch is performed by the timer 3 interrupt, 
+ * which has the same (low) priority as the kernel aware interrupts, so it 
+ * runs once the requesting ISR has exited - and the ISR frame is not copied
+ * as part of the stack of the interrupted task.  Timer 3 is reserved by the
+ * port for this purpose - it is never started, only its interrupt flag is 
+ * set.
+ */
+#define portYIELD_SFR_PAGE			( ( unsigned portCHAR ) 0x01 )
+
+#if portUSE_PREEMPTION == 1
+	#define portYIELD_FROM_ISR( cSwitchRequired )								\
+	{																			\
+		if( cSwitchRequired )													\
+		{																		\
+			unsigned portCHAR ucYieldSFRPage;									\
+																				\
+			ucYieldSFRPage = SFRPAGE;											\
+			SFRPAGE = portYIELD_SFR_PAGE;										\
+			TF3 = 1;															\
+			SFRPAGE = ucYieldSFRPage;											\
+		}																		\
+	}
+#else
+	/* Woken tasks will run at the next cooperative yield. */
+	#define portYIELD_FROM_ISR( cSwitchRequired )	( void ) ( cSwitchRequired );
+#endif
+
+/*
+ * Returns the number of context switches for which the scheduler selected 
+ * the task that was already running, so the idata<->XRAM stack copies were
+ * not performed.
+ */
+unsigned portLONG ulPortGetSkippedStackCopies( void );
+
+/*
+ * Returns the longest time, in CPU clock cycles, from the start of a tick 
+ * period to the tick interrupt being ready to restore the context - the 
+ * interrupt latency, vTaskIncrementTick(), vTaskSwitchContext() and the 
+ * stack copies when using preemption.  Ticks handled by the fast path 
+ * without calling the kernel are included.  Only the final register 
+ * restore and reti are not measured.  Divide by portCPU_CLOCK for the time 
+ * in seconds.
+ * Only available when USE_TRACE_FACILITY is 1.
+ */
+unsigned portLONG ulPortGetMaxTickClocks( void );
+
+/*
+ * Give a task one of register banks 2 or 3 to keep R0-R7 in while it is not
+ * running.  Must be called after the task has been created, but before the
+ * scheduler is started.  Returns pdFAIL if the bank is invalid or already
+ * in use.
+ */
+#if portUSE_TASK_REGISTER_BANKS == 1
+	portSHORT sPortSetTaskRegisterBank( void *xTask, unsigned portCHAR ucBank );
+#endif
+
+/*
+ * Setup the initial context of a task that has been given a resident stack 
+ * slot.  Called by sTaskCreateResident().
+ */
+#if portNUM_STACK_SLOTS > 0
+	void vPortInitialiseStackSlot( unsigned portCHAR ucSlot, pdTASK_CODE pxCode, void *pvParameters );
+#endif
+
+/*
+ * Called by the idle task, with the scheduler suspended, to stop the tick and
+ * sleep until the next delayed task is due to wake or an interrupt occurs.
+ */
+#if portUSE_TICKLESS_IDLE == 1
+	void vPortSuppressTicksAndSleep( void );
+#endif
+
+
+/* The interrupt vector of the tick source. */
+#if portTICK_SOURCE == portTICK_SOURCE_TIMER_0
+	#define portTICK_VECTOR		1
+#elif portTICK_SOURCE == portTICK_SOURCE_TIMER_2
+	#define portTICK_VECTOR		5
+#elif portTICK_SOURCE == portTICK_SOURCE_TIMER_3
+	#define portTICK_VECTOR		14
+#elif portTICK_SOURCE == portTICK_SOURCE_TIMER_4
+	#define portTICK_VECTOR		16
+#elif portTICK_SOURCE == portTICK_SOURCE_PCA
+	#define portTICK_VECTOR		9
+#else
+	#error "portTICK_SOURCE is not a valid tick source."
+#endif
 
 /* All ISR's must have a prototype in the file containing main. */
 #if portUSE_PREEMPTION == 0
-	void vTimer2ISR( void ) interrupt 5;
+	void vPortTickISR( void ) interrupt portTICK_VECTOR;
 #else
-	void vTimer2ISR( void ) interrupt 5 _naked;
+	void vPortTickISR( void ) interrupt portTICK_VECTOR _naked;
+	void vTimer3ISR( void ) interrupt 14 _naked;
 #endif
 
 void vSerialISR( void ) interrupt 4;
@@ -55,6 +55,10 @@ Changed from V2.2.0
 #include "task.h"
 #include "list.h"
 
+#if( USE_CO_ROUTINES == 1 )
+	#include "croutine.h"
+#endif
+
 /*-----------------------------------------------------------
  * PUBLIC LIST API documented in list.h
  *----------------------------------------------------------*/
@@ -68,11 +72,11 @@ Changed from V2.2.0
  */
 typedef struct QueueDefinition
 {
-	signed portCHAR *pcHead;				/*< Points to the beginning of the queue storage area. */
-	signed portCHAR *pcTail;				/*< Points to the byte at the end of the queue storage area.  Once more byte is allocated than necessary to store the queue items, this is used as a marker. */
+	signed portCHAR portOBJECT_SPACE *pcHead;		/*< Points to the beginning of the queue storage area. */
+	signed portCHAR portOBJECT_SPACE *pcTail;		/*< Points to the byte at the end of the queue storage area.  Once more byte is allocated than necessary to store the queue items, this is used as a marker. */
 
-	signed portCHAR *pcWriteTo;				/*< Points to the free next place in the storage area. */
-	signed portCHAR *pcReadFrom;			/*< Points to the last place that a queued item was read from. */
+	signed portCHAR portOBJECT_SPACE *pcWriteTo;	/*< Points to the free next place in the storage area. */
+	signed portCHAR portOBJECT_SPACE *pcReadFrom;	/*< Points to the last place that a queued item was read from. */
 
 	xList xTasksWaitingToSend;				/*< List of tasks that are blocked waiting to post onto this queue.  Stored in priority order. */
 	xList xTasksWaitingToReceive;			/*< List of tasks that are blocked waiting to read from this queue.  Stored in priority order. */
@@ -91,7 +95,7 @@ typedef struct QueueDefinition
  * To keep the definition private the API header file defines it as a
  * pointer to void. 
  */
-typedef xQUEUE * xQueueHandle;
+typedef xQUEUE portOBJECT_SPACE * xQueueHandle;
 
 /*
  * Prototypes for public functions are included here so we don't have to
@@ -105,6 +109,17 @@ void vQueueDelete( xQueueHandle xQueue );
 signed portCHAR cQueueSendFromISR( xQueueHandle pxQueue, const void *pvItemToQueue, signed portCHAR cTaskPreviouslyWoken );
 signed portCHAR cQueueReceive( xQueueHandle pxQueue, void *pcBuffer, portTickType xTicksToWait );
 
+/*
+ * Co-routine queue functions differ from task queue functions.  Co-routines are
+ * an optional component.
+ */
+#if USE_CO_ROUTINES == 1
+	signed portCHAR cQueueCRSendFromISR( xQueueHandle pxQueue, const void *pvItemToQueue, signed portCHAR cCoRoutinePreviouslyWoken );
+	signed portCHAR cQueueCRReceiveFromISR( xQueueHandle pxQueue, void *pvBuffer, signed portCHAR *pcCoRoutineWoken );
+	signed portCHAR cQueueCRSend( xQueueHandle pxQueue, const void *pvItemToQueue, portTickType xTicksToWait );
+	signed portCHAR cQueueCRReceive( xQueueHandle pxQueue, void *pvBuffer, portTickType xTicksToWait );
+#endif
+
 /* 
  * Unlocks a queue locked by a call to prvLockQueue.  Locking a queue does not 
  * prevent an ISR from adding or removing items to the queue, but does prevent 
@@ -166,20 +181,20 @@ static signed portCHAR prvIsQueueFull( const xQueueHandle pxQueue );
 
 xQueueHandle xQueueCreate( unsigned portCHAR ucQueueLength, unsigned portCHAR ucItemSize )
 {
-xQUEUE *pxNewQueue;
+xQUEUE portOBJECT_SPACE *pxNewQueue;
 unsigned portSHORT usQueueSizeInBytes;
 
 	/* Allocate the new queue structure. */
 	if( ucQueueLength > ( unsigned portCHAR ) 0 )
 	{
-		pxNewQueue = ( xQUEUE * ) pvPortMalloc( sizeof( xQUEUE ) );
+		pxNewQueue = ( xQUEUE portOBJECT_SPACE * ) pvPortMalloc( sizeof( xQUEUE ) );
 		if( pxNewQueue != NULL )
 		{
 			/* Create the list of pointers to queue items.  The queue is one byte 
 			longer than asked for to make wrap checking easier/faster. */
 			usQueueSizeInBytes = ( unsigned portSHORT ) ( ucQueueLength * ucItemSize ) + ( unsigned portSHORT ) 1;
 
-			pxNewQueue->pcHead = ( signed portCHAR * ) pvPortMalloc( usQueueSizeInBytes );
+			pxNewQueue->pcHead = ( signed portCHAR portOBJECT_SPACE * ) pvPortMalloc( usQueueSizeInBytes );
 			if( pxNewQueue->pcHead != NULL )
 			{
 				/* Initialise the queue members as described above where the 
@@ -537,6 +552,167 @@ signed portCHAR cReturn;
 }
 /*-----------------------------------------------------------*/
 
+#if USE_CO_ROUTINES == 1
+
+signed portCHAR cQueueCRSend( xQueueHandle pxQueue, const void *pvItemToQueue, portTickType xTicksToWait )
+{
+signed portCHAR cReturn;
+
+	/* Co-routines cannot be pre-empted by each other, so the queue need not
+	be locked - only protected from ISRs for as long as it is accessed.  As
+	queues used by co-routines are not used by tasks the event lists only ever
+	hold co-routines. */
+	taskENTER_CRITICAL();
+	{
+		if( pxQueue->ucMessagesWaiting < pxQueue->ucLength )
+		{
+			prvCopyQueueData( pxQueue, pvItemToQueue );
+			cReturn = ( signed portCHAR ) pdPASS;
+
+			/* Was a co-routine waiting for data to become available? */
+			if( !listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) )
+			{
+				/* The co-routine is placed in the pending ready list.  If it
+				has a priority no lower than ours we yield to let it run. */
+				if( cCoRoutineRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) ) != ( signed portCHAR ) pdFALSE )
+				{
+					cReturn = errQUEUE_YIELD;
+				}
+			}
+		}
+		else if( xTicksToWait > ( portTickType ) 0 )
+		{
+			/* The queue is full - block on the queue.  The crQUEUE_SEND() 
+			macro returns from the co-routine and calls back in here once
+			the co-routine is woken or the block time expires. */
+			vCoRoutineAddToDelayedList( xTicksToWait, &( pxQueue->xTasksWaitingToSend ) );
+			cReturn = errQUEUE_BLOCKED;
+		}
+		else
+		{
+			cReturn = errQUEUE_FULL;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return cReturn;
+}
+/*-----------------------------------------------------------*/
+
+signed portCHAR cQueueCRReceive( xQueueHandle pxQueue, void *pvBuffer, portTickType xTicksToWait )
+{
+signed portCHAR cReturn;
+
+	/* See the comments in cQueueCRSend(). */
+	taskENTER_CRITICAL();
+	{
+		if( pxQueue->ucMessagesWaiting > ( unsigned portCHAR ) 0 )
+		{
+			/* Data is available from the queue. */
+			pxQueue->pcReadFrom += pxQueue->ucItemSize;
+			if( pxQueue->pcReadFrom >= pxQueue->pcTail )
+			{
+				pxQueue->pcReadFrom = pxQueue->pcHead;
+			}
+			--( pxQueue->ucMessagesWaiting );
+			memcpy( ( void * ) pvBuffer, ( void * ) pxQueue->pcReadFrom, ( unsigned ) pxQueue->ucItemSize );
+			cReturn = ( signed portCHAR ) pdPASS;
+
+			/* Was a co-routine waiting for space to become available? */
+			if( !listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToSend ) ) )
+			{
+				if( cCoRoutineRemoveFromEventList( &( pxQueue->xTasksWaitingToSend ) ) != ( signed portCHAR ) pdFALSE )
+				{
+					cReturn = errQUEUE_YIELD;
+				}
+			}
+		}
+		else if( xTicksToWait > ( portTickType ) 0 )
+		{
+			/* The queue is empty - block on the queue. */
+			vCoRoutineAddToDelayedList( xTicksToWait, &( pxQueue->xTasksWaitingToReceive ) );
+			cReturn = errQUEUE_BLOCKED;
+		}
+		else
+		{
+			cReturn = ( signed portCHAR ) pdFAIL;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return cReturn;
+}
+/*-----------------------------------------------------------*/
+
+signed portCHAR cQueueCRSendFromISR( xQueueHandle pxQueue, const void *pvItemToQueue, signed portCHAR cCoRoutinePreviouslyWoken )
+{
+	/* Cannot block within an ISR so if there is no space on the queue then
+	exit without doing anything. */
+	if( pxQueue->ucMessagesWaiting < pxQueue->ucLength )
+	{
+		prvCopyQueueData( pxQueue, pvItemToQueue );
+
+		/* We only want to wake one co-routine per ISR, so check that a 
+		co-routine has not already been woken. */
+		if( !cCoRoutinePreviouslyWoken )		
+		{
+			if( !listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) )
+			{
+				if( cCoRoutineRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) ) != ( signed portCHAR ) pdFALSE )
+				{
+					return pdTRUE;
+				}
+			}
+		}
+	}
+
+	return cCoRoutinePreviouslyWoken;
+}
+/*-----------------------------------------------------------*/
+
+signed portCHAR cQueueCRReceiveFromISR( xQueueHandle pxQueue, void *pvBuffer, signed portCHAR *pcCoRoutineWoken )
+{
+signed portCHAR cReturn;
+
+	/* We cannot block from an ISR, so check there is data available. If
+	not then just leave without doing anything. */
+	if( pxQueue->ucMessagesWaiting > ( unsigned portCHAR ) 0 )
+	{
+		/* Copy the data from the queue. */
+		pxQueue->pcReadFrom += pxQueue->ucItemSize;
+		if( pxQueue->pcReadFrom >= pxQueue->pcTail )
+		{
+			pxQueue->pcReadFrom = pxQueue->pcHead;
+		}
+		--( pxQueue->ucMessagesWaiting );
+		memcpy( ( void * ) pvBuffer, ( void * ) pxQueue->pcReadFrom, ( unsigned ) pxQueue->ucItemSize );
+
+		/* We only want to wake one co-routine per ISR, so check that a 
+		co-routine has not already been woken. */
+		if( !( *pcCoRoutineWoken ) )
+		{
+			if( !listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToSend ) ) )
+			{
+				if( cCoRoutineRemoveFromEventList( &( pxQueue->xTasksWaitingToSend ) ) != ( signed portCHAR ) pdFALSE )
+				{
+					*pcCoRoutineWoken = ( signed portCHAR ) pdTRUE;
+				}
+			}
+		}
+
+		cReturn = ( signed portCHAR ) pdPASS;
+	}
+	else
+	{
+		cReturn = ( signed portCHAR ) pdFAIL;
+	}
+
+	return cReturn;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* USE_CO_ROUTINES */
+
 unsigned portCHAR ucQueueMessagesWaiting( xQueueHandle pxQueue )
 {
 unsigned portCHAR ucReturn;
@@ -86,6 +86,59 @@ Changes from V2.2.0
 	+ Changed odd calculation of initial pxTopOfStack value when 
 	  portSTACK_GROWTH < 0.
 	+ Removed pcVersionNumber definition.
+
+Changes from V2.4.1
+
+	+ xTickCount is no longer file private, and xNextTaskUnblockTime has been
+	  introduced.  Together these allow a port to process most ticks without
+	  calling into the kernel.
+	+ sTaskCreateResident() added for ports that can give a task a fixed
+	  stack area in place of a stack allocated from the heap.
+	+ vTaskGetStackUsage() added.  The port records the deepest stack of each
+	  task as it is switched out when USE_TRACE_FACILITY is 1.  The free stack
+	  space reported by vTaskList() is correct for stacks that grow upwards.
+	+ Optional tickless idle.  When portUSE_TICKLESS_IDLE is 1 the idle task
+	  asks the port to suppress the tick until the first delayed task is due
+	  to wake.  xTaskGetExpectedIdleTime() and vTaskStepTick() added for use
+	  by the port.
+	+ Kernel variables are declared with the portKERNEL_HOT_DATA and 
+	  portKERNEL_DATA memory space qualifiers so the kernel can be built 
+	  with compilers that would otherwise place them in a small, fast but 
+	  limited memory space.
+	+ The pointers within list items, lists, TCBs and queues are declared
+	  with the portOBJECT_SPACE qualifier.  A port that keeps all such 
+	  objects in one memory space can then use smaller, faster pointers.
+	+ Optional ready priority bitmap.  When USE_PRIORITY_BITMAP is 1 the
+	  highest priority ready task is found in constant time using lookup
+	  tables, in place of searching down through the empty ready lists.
+	  Up to 16 priorities are supported.
+	+ Optional timing wheel.  When USE_TIMING_WHEEL is 1 delayed and blocked
+	  tasks are held in portTIMING_WHEEL_SLOTS unsorted lists selected by
+	  wake time, so blocking takes constant time and the tick only inspects
+	  one slot.  The tick count wraps without swapping lists.
+	+ Ticks missed while the scheduler is suspended are counted in a
+	  portTickType, and are processed by cTaskResumeAll() in a single pass
+	  rather than one call to vTaskIncrementTick() per tick.
+	+ cTaskDelayUntil() added for tasks that must execute at a fixed
+	  frequency.
+	+ Optional tick epoch.  When USE_TICK_EPOCH is 1 the number of times the
+	  16 bit tick count has wrapped is counted, and vTaskDelayLong() and 
+	  ulTaskGetExtendedTickCount() are added.  Tasks delayed beyond the 
+	  current epoch wait on a separate list until their epoch starts.
+	+ portMAX_TASKS_WOKEN_PER_TICK limits the number of delayed tasks the tick
+	  makes ready.  Any others that are due are made ready by the ticks that
+	  follow.
+	+ vTaskStartScheduler() creates the software timer task (see timers.c)
+	  when USE_TIMERS is 1.
+	+ The idle task runs the co-routines (see croutine.c) when 
+	  USE_CO_ROUTINES is 1.
+	+ Task notifications.  When USE_TASK_NOTIFICATIONS is 1 each TCB holds a
+	  notification value that cTaskNotify() and cTaskNotifyFromISR() update 
+	  and cTaskNotifyWait() and ulTaskNotifyTake() wait on, without the need
+	  for a queue.
+	+ vTaskPlaceOnUnorderedEventList(), cTaskRemoveFromUnorderedEventList()
+	  and xTaskResetEventItemValue() added for the event groups (see 
+	  event_groups.c).
 */
 
 #include <stdio.h>
@@ -97,19 +150,40 @@ Changes from V2.2.0
 #include "task.h"
 #include "errors.h"
 
+#if( USE_TIMERS == 1 )
+	#include "timers.h"
+#endif
+
+#if( USE_CO_ROUTINES == 1 )
+	#include "croutine.h"
+#endif
+
 /*
  * Macro to define the amount of stack available to the idle task.
  */
 #define tskIDLE_STACK_SIZE	portMINIMAL_STACK_SIZE
 
+/*
+ * Values for the ucNotifyState member of the TCB.
+ */
+#define tskNOT_WAITING_NOTIFICATION		( ( unsigned portCHAR ) 0 )
+#define tskWAITING_NOTIFICATION			( ( unsigned portCHAR ) 1 )
+#define tskNOTIFICATION_RECEIVED		( ( unsigned portCHAR ) 2 )
+
 /*
  * Task control block.  A task control block (TCB) is allocated to each task,
  * and stores the context of the task.
  */
 typedef struct tskTaskControlBlock
 {
-	portSTACK_TYPE		*pxTopOfStack;						/*< Points to the location of the last item placed on the tasks stack.  THIS MUST BE THE FIRST MEMBER OF THE STRUCT. */
-	portSTACK_TYPE		*pxStack;							/*< Points to the start of the stack. */
+	portSTACK_TYPE portOBJECT_SPACE	*pxTopOfStack;			/*< Points to the location of the last item placed on the tasks stack.  THIS MUST BE THE FIRST MEMBER OF THE STRUCT. */
+	#if( portNUM_STACK_SLOTS > 0 )
+		unsigned portCHAR	ucStackSlot;					/*< The resident stack slot used by the task, or portNO_STACK_SLOT.  THIS MUST BE THE SECOND MEMBER OF THE STRUCT. */
+	#endif
+	#if( USE_TRACE_FACILITY == 1 )
+		unsigned portCHAR	ucMaxStackBytes;				/*< The deepest stack recorded by the port when switching the task out.  THIS MUST FOLLOW THE MEMBERS ABOVE. */
+	#endif
+	portSTACK_TYPE portOBJECT_SPACE	*pxStack;				/*< Points to the start of the stack. */
 	unsigned portSHORT	usStackDepth;						/*< Total depth of the stack (when empty).  This is defined as the number of variables the stack can hold, not the number of bytes. */
 	signed portCHAR		pcTaskName[ tskMAX_TASK_NAME_LEN ];	/*< Descriptive name given to the task when created.  Facilitates debugging only. */
 	unsigned portCHAR	ucPriority;							/*< The priority of the task where 0 is the lowest priority. */
@@ -118,42 +192,123 @@ typedef struct tskTaskControlBlock
 	xListItem			xEventListItem;						/*< List item used to place the TCB in event lists. */
 
 	unsigned portCHAR	ucTCBNumber;						/*< This is used for tracing the scheduler only. */
+
+	#if( USE_TASK_NOTIFICATIONS == 1 )
+		volatile unsigned portLONG	ulNotifiedValue;		/*< The notification value sent to the task by cTaskNotify(). */
+		volatile unsigned portCHAR	ucNotifyState;			/*< One of the tskNOTIFICATION_ states below. */
+	#endif
 } tskTCB;
 
 /*lint -e956 */
 
-volatile tskTCB * volatile pxCurrentTCB = NULL;					
+volatile tskTCB portOBJECT_SPACE * volatile portKERNEL_HOT_DATA pxCurrentTCB = NULL;					
 
 /* Lists for ready and blocked tasks. --------------------*/
 
-static volatile xList pxReadyTasksLists[ portMAX_PRIORITIES ];	/*< Prioratised ready tasks. */
-static volatile xList xDelayedTaskList1;						/*< Delayed tasks. */
-static volatile xList xDelayedTaskList2;						/*< Delayed tasks (two lists are used - one for delays that have overflowed the current tick count. */
-static volatile xList *pxDelayedTaskList;						/*< Points to the delayed task list currently being used. */
-static volatile xList *pxOverflowDelayedTaskList;				/*< Points to the delayed task list currently being used to hold tasks that have overflowed the current tick count. */
-static volatile xList xPendingReadyList;						/*< Tasks that have been readied while the scheduler was suspended.  They will be moved to the ready queue when the scheduler is resumed. */
+static volatile xList portKERNEL_DATA pxReadyTasksLists[ portMAX_PRIORITIES ];	/*< Prioratised ready tasks. */
+#if( USE_TIMING_WHEEL == 1 )
+
+	#if( ( portTIMING_WHEEL_SLOTS < 2 ) || ( portTIMING_WHEEL_SLOTS > 128 ) || ( ( portTIMING_WHEEL_SLOTS & ( portTIMING_WHEEL_SLOTS - 1 ) ) != 0 ) )
+		#error "portTIMING_WHEEL_SLOTS must be a power of 2 between 2 and 128."
+	#endif
+
+	#define tskTIMING_WHEEL_MASK	( ( portTickType ) ( portTIMING_WHEEL_SLOTS - 1 ) )
+
+	static volatile xList portKERNEL_DATA xTimingWheel[ portTIMING_WHEEL_SLOTS ];	/*< Delayed tasks, in the slot selected by the low bits of their wake time.  The slots are not sorted. */
+
+#else
+
+	static volatile xList portKERNEL_DATA xDelayedTaskList1;						/*< Delayed tasks. */
+	static volatile xList portKERNEL_DATA xDelayedTaskList2;						/*< Delayed tasks (two lists are used - one for delays that have overflowed the current tick count. */
+	static volatile xList portOBJECT_SPACE * portKERNEL_DATA pxDelayedTaskList;						/*< Points to the delayed task list currently being used. */
+	static volatile xList portOBJECT_SPACE * portKERNEL_DATA pxOverflowDelayedTaskList;				/*< Points to the delayed task list currently being used to hold tasks that have overflowed the current tick count. */
+
+#endif
+
+static volatile xList portKERNEL_DATA xPendingReadyList;						/*< Tasks that have been readied while the scheduler was suspended.  They will be moved to the ready queue when the scheduler is resumed. */
+
+#if( USE_TICK_EPOCH == 1 )
+
+	#if( USE_16_BIT_TICKS != 1 )
+		#error "USE_TICK_EPOCH requires USE_16_BIT_TICKS."
+	#endif
+
+	static volatile xList portKERNEL_DATA xLongDelayTaskList;					/*< Tasks delayed until a later tick epoch.  The list item value is the epoch in which the task is to wake.  The list is not sorted. */
+
+#endif
 
 #if( INCLUDE_vTaskDelete == 1 )
 
-	static volatile xList xTasksWaitingTermination;				/*< Tasks that have been deleted - but the their memory not yet freed. */
+	static volatile xList portKERNEL_DATA xTasksWaitingTermination;				/*< Tasks that have been deleted - but the their memory not yet freed. */
 
 #endif
 
 #if( INCLUDE_vTaskSuspend == 1 )
 
-	static volatile xList xSuspendedTaskList;					/*< Tasks that are currently suspended. */
+	static volatile xList portKERNEL_DATA xSuspendedTaskList;					/*< Tasks that are currently suspended. */
 
 #endif
 
 /* File private variables. --------------------------------*/
-static portSHORT sUsingPreemption = pdFALSE;
-static unsigned portSHORT usCurrentNumberOfTasks = ( unsigned portSHORT ) 0;              
-static volatile portTickType xTickCount = ( portTickType ) 0;				/* Modified by tick ISR. */
-static unsigned portCHAR ucTopUsedPriority = tskIDLE_PRIORITY;
-static volatile unsigned portCHAR ucTopReadyPriority = tskIDLE_PRIORITY;
-static signed portCHAR cSchedulerRunning = pdFALSE;
-static volatile unsigned portCHAR ucSchedulerSuspended = pdFALSE;
-static volatile unsigned portCHAR ucMissedTicks = ( unsigned portCHAR ) 0;
+static portSHORT portKERNEL_DATA sUsingPreemption = pdFALSE;
+static unsigned portSHORT portKERNEL_DATA usCurrentNumberOfTasks = ( unsigned portSHORT ) 0;              
+static unsigned portCHAR portKERNEL_DATA ucTopUsedPriority = tskIDLE_PRIORITY;
+static volatile unsigned portCHAR portKERNEL_HOT_DATA ucTopReadyPriority = tskIDLE_PRIORITY;
+static signed portCHAR portKERNEL_DATA cSchedulerRunning = pdFALSE;
+static volatile unsigned portCHAR portKERNEL_HOT_DATA ucSchedulerSuspended = pdFALSE;
+static volatile portTickType portKERNEL_DATA xMissedTicks = ( portTickType ) 0;
+
+/* Set when the tick has not made ready every delayed task that is due, 
+because of portMAX_TASKS_WOKEN_PER_TICK.  The remaining tasks are made ready
+by the ticks that follow. */
+static volatile signed portCHAR portKERNEL_DATA cDelayedTasksPending = pdFALSE;
+
+#if( USE_TIMING_WHEEL == 1 )
+
+	/* The first tick whose due tasks might not all have been made ready.
+	Only valid while cDelayedTasksPending is set. */
+	static volatile portTickType portKERNEL_DATA xFirstPendingTick = ( portTickType ) 0;
+
+#endif
+
+#if( USE_TICK_EPOCH == 1 )
+
+	static volatile unsigned portSHORT portKERNEL_DATA usTickEpoch = ( unsigned portSHORT ) 0;
+
+#endif
+
+/* One bit for each priority that has a task in its ready list. */
+#if( USE_PRIORITY_BITMAP == 1 )
+
+	#if( portMAX_PRIORITIES > 16 )
+		#error "The priority bitmap supports up to 16 priorities."
+	#endif
+
+	#define tskPRIORITY_BITMAP_BYTES	( ( portMAX_PRIORITIES + 7 ) / 8 )
+
+	static volatile unsigned portCHAR portKERNEL_HOT_DATA ucReadyPriorities[ tskPRIORITY_BITMAP_BYTES ];
+
+	/* The bit within ucReadyPriorities for each priority, and the highest bit
+	set in each nibble value.  Using tables avoids variable length shift 
+	loops, so every operation on the bitmap takes a fixed time. */
+	static const unsigned portCHAR portCODE_SPACE ucPriorityBit[ 8 ] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+	static const unsigned portCHAR portCODE_SPACE ucHighestBitInNibble[ 16 ] = { 0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3 };
+
+#endif
+
+/* Scheduler variables that can also be accessed by the portable layer. ---*/
+
+/* Modified by tick ISR. */
+volatile portTickType portKERNEL_DATA xTickCount = ( portTickType ) 0;
+
+/* The tick count at which the kernel next needs to process a tick.  Until the
+tick count reaches this value no delayed task can become ready and no time
+slicing is required, so the tick ISR need only increment xTickCount.  The value
+may be earlier than strictly necessary, but never later.  The port compares it
+with the tick count as a range, treating a value more than half the range of
+portTickType ahead of the tick count as already passed, so it is never set 
+further ahead than tskMAX_UNBLOCK_AHEAD ticks. */
+volatile portTickType portKERNEL_DATA xNextTaskUnblockTime = ( portTickType ) 1;
 
 /* Debugging and trace facilities private variables and macros. ------------*/
 
@@ -177,10 +332,10 @@ static volatile unsigned portCHAR ucMissedTicks = ( unsigned portCHAR ) 0;
 #if( USE_TRACE_FACILITY == 1 )
 
 	#define tskSIZE_OF_EACH_TRACE_LINE			( sizeof( unsigned portLONG ) + sizeof( unsigned portCHAR ) )
-	static volatile signed portCHAR * volatile pcTraceBuffer;
-	static signed portCHAR *pcTraceBufferStart;
-	static signed portCHAR *pcTraceBufferEnd;
-	static signed portCHAR cTracing = ( signed portCHAR ) pdFALSE;
+	static volatile signed portCHAR * volatile portKERNEL_DATA pcTraceBuffer;
+	static signed portCHAR * portKERNEL_DATA pcTraceBufferStart;
+	static signed portCHAR * portKERNEL_DATA pcTraceBufferEnd;
+	static signed portCHAR portKERNEL_DATA cTracing = ( signed portCHAR ) pdFALSE;
 
 #endif
 
@@ -196,7 +351,7 @@ static volatile unsigned portCHAR ucMissedTicks = ( unsigned portCHAR ) 0;
 	{																					\
 		if( cTracing )																	\
 		{																				\
-			static unsigned portCHAR ucPreviousTask = 255;								\
+			static unsigned portCHAR portKERNEL_DATA ucPreviousTask = 255;				\
 																						\
 			if( ucPreviousTask != pxCurrentTCB->ucTCBNumber )							\
 			{																			\
@@ -223,6 +378,78 @@ static volatile unsigned portCHAR ucMissedTicks = ( unsigned portCHAR ) 0;
 #endif
 
 
+/*
+ * Macros that keep ucReadyPriorities up to date.  prvRecordReadyPriority()
+ * is used when a task is placed in a ready list.  prvResetReadyPriority() is
+ * used after a task is removed from the ready list of the given priority - or
+ * from a list that might have been that ready list.  
+ * prvSelectHighestReadyPriority() sets ucTopReadyPriority to the highest
+ * priority that has a ready task.  
+ */
+#if( USE_PRIORITY_BITMAP == 1 )
+
+	#define prvRecordReadyPriority( ucPriority )											\
+	{																						\
+		ucReadyPriorities[ ( ucPriority ) >> 3 ] |= ucPriorityBit[ ( ucPriority ) & 7 ];	\
+	}
+
+	#define prvResetReadyPriority( ucPriority )												\
+	{																						\
+		if( listLIST_IS_EMPTY( &( pxReadyTasksLists[ ( ucPriority ) ] ) ) )					\
+		{																					\
+			ucReadyPriorities[ ( ucPriority ) >> 3 ] &= ~ucPriorityBit[ ( ucPriority ) & 7 ];	\
+		}																					\
+	}
+
+	#define prvHighestBitInByte( ucBit, ucByte )											\
+	{																						\
+		if( ( ucByte ) & ( unsigned portCHAR ) 0xf0 )										\
+		{																					\
+			ucBit = ucHighestBitInNibble[ ( ucByte ) >> 4 ] + ( unsigned portCHAR ) 4;		\
+		}																					\
+		else																				\
+		{																					\
+			ucBit = ucHighestBitInNibble[ ( ucByte ) ];										\
+		}																					\
+	}
+
+	#if( tskPRIORITY_BITMAP_BYTES > 1 )
+
+		#define prvSelectHighestReadyPriority()												\
+		{																					\
+			if( ucReadyPriorities[ 1 ] != ( unsigned portCHAR ) 0 )						\
+			{																				\
+				prvHighestBitInByte( ucTopReadyPriority, ucReadyPriorities[ 1 ] );			\
+				ucTopReadyPriority += ( unsigned portCHAR ) 8;								\
+			}																				\
+			else																			\
+			{																				\
+				prvHighestBitInByte( ucTopReadyPriority, ucReadyPriorities[ 0 ] );			\
+			}																				\
+		}
+
+	#else
+
+		#define prvSelectHighestReadyPriority()	prvHighestBitInByte( ucTopReadyPriority, ucReadyPriorities[ 0 ] )
+
+	#endif
+
+#else
+
+	#define prvRecordReadyPriority( ucPriority )
+	#define prvResetReadyPriority( ucPriority )
+
+	/* Search down from the highest priority that might have a ready task. */
+	#define prvSelectHighestReadyPriority()													\
+	{																						\
+		while( listLIST_IS_EMPTY( &( pxReadyTasksLists[ ucTopReadyPriority ] ) ) )			\
+		{																					\
+			--ucTopReadyPriority;															\
+		}																					\
+	}
+
+#endif
+
 /*
  * Place the task represented by pxTCB into the appropriate ready queue for
  * the task.  It is inserted at the end of the list.  One quirk of this is
@@ -237,27 +464,203 @@ static volatile unsigned portCHAR ucMissedTicks = ( unsigned portCHAR ) 0;
 	{																											\
 		ucTopReadyPriority = pxTCB->ucPriority;																	\
 	}																											\
-	vListInsertEnd( ( xList * ) &( pxReadyTasksLists[ pxTCB->ucPriority ] ), &( pxTCB->xGenericListItem ) );	\
+	prvRecordReadyPriority( pxTCB->ucPriority );																\
+	vListInsertEnd( ( xList portOBJECT_SPACE * ) &( pxReadyTasksLists[ pxTCB->ucPriority ] ), &( pxTCB->xGenericListItem ) );	\
+	prvForceTickProcessing();																					\
 }	
 
+/*
+ * Ensure the next tick is passed to vTaskIncrementTick() and followed by a
+ * call to vTaskSwitchContext(), rather than just incrementing the tick count.
+ * Used whenever the ready lists change in a way that might require a switch
+ * at the next tick, and while the scheduler is suspended (the tick must then
+ * be counted as missed).  MUST BE CALLED WITH INTERRUPTS DISABLED.
+ */
+#define prvForceTickProcessing()	{ xNextTaskUnblockTime = xTickCount + ( portTickType ) 1; }
+
+/*
+ * Limit xNextTaskUnblockTime to tskMAX_UNBLOCK_AHEAD ticks after xTickCount, 
+ * as a time further ahead would appear to the port to have already passed.
+ * The tick processed at the limit finds nothing to do and sets it again.
+ * MUST BE CALLED WITH INTERRUPTS DISABLED.
+ */
+#define tskMAX_UNBLOCK_AHEAD		( portMAX_DELAY >> 1 )
+
+#define prvLimitNextTaskUnblockTime()															\
+{																								\
+	if( ( portTickType ) ( xNextTaskUnblockTime - xTickCount ) > tskMAX_UNBLOCK_AHEAD )			\
+	{																							\
+		xNextTaskUnblockTime = xTickCount + tskMAX_UNBLOCK_AHEAD;								\
+	}																							\
+}
+
+/*
+ * True once ucWoken delayed tasks have been made ready, where ucMaxWakes is
+ * the most that may be made ready in one go.  A ucMaxWakes of 0 means there 
+ * is no limit, in which case the test is removed by the compiler.
+ */
+#define prvWakeLimitReached( ucWoken, ucMaxWakes )	( ( ( ucMaxWakes ) != 0 ) && ( ( ucWoken ) >= ( unsigned portCHAR ) ( ucMaxWakes ) ) )
+
+#if( USE_TIMING_WHEEL == 1 )
+
+/*
+ * Macro that wakes the delayed tasks in the timing wheel slot for tick
+ * xSlotTime whose wake time is one of the xTicks ticks starting at xFirstTick.
+ * ucWoken counts the tasks made ready, and the walk stops early once 
+ * ucMaxWakes have been made ready.
+ *
+ * A slot holds, unsorted, every delayed task whose wake time maps onto it, so
+ * the tasks outside the range are left alone - they are due on a later turn of
+ * the wheel.  The wake times are compared relative to xFirstTick, at the
+ * width of portTickType, so the tick count can wrap without any special 
+ * handling.  The pointer to the next item is taken before an item is removed
+ * from the slot.
+ */
+#define prvWakeTasksInSlot( xSlotTime, xFirstTick, xTicks, ucWoken, ucMaxWakes )			\
+{																								\
+register volatile xListItem portOBJECT_SPACE *pxItem;											\
+volatile xListItem portOBJECT_SPACE *pxNextItem;												\
+volatile xList portOBJECT_SPACE *pxSlot;														\
+tskTCB portOBJECT_SPACE *pxTCB;																	\
+																								\
+	pxSlot = &( xTimingWheel[ ( xSlotTime ) & tskTIMING_WHEEL_MASK ] );							\
+	pxItem = pxSlot->pxHead->pxNext;															\
+	while( ( pxItem != pxSlot->pxHead ) && !prvWakeLimitReached( ucWoken, ucMaxWakes ) )		\
+	{																							\
+		pxNextItem = pxItem->pxNext;															\
+		if( ( portTickType ) ( listGET_LIST_ITEM_VALUE( pxItem ) - ( xFirstTick ) ) < ( xTicks ) )	\
+		{																						\
+			pxTCB = ( tskTCB portOBJECT_SPACE * ) pxItem->pvOwner;								\
+			vListRemove( &( pxTCB->xGenericListItem ) );										\
+			/* Is the task waiting on an event also? */											\
+			if( pxTCB->xEventListItem.pvContainer )												\
+			{																					\
+				vListRemove( &( pxTCB->xEventListItem ) );										\
+			}																					\
+			prvAddTaskToReadyQueue( pxTCB );													\
+			++( ucWoken );																		\
+		}																						\
+		pxItem = pxNextItem;																	\
+	}																							\
+}
+
+/*
+ * Macro that sets xNextTaskUnblockTime to the first tick after xTickCount 
+ * whose timing wheel slot is not empty.
+ *
+ * The tasks in that slot may not be due until a later turn of the wheel, so
+ * this can be earlier than necessary, but never later.  If every slot is empty
+ * the value used is as far ahead as the port allows.
+ */
+#define prvSetNextTaskUnblockTime()																\
+{																								\
+unsigned portCHAR ucSlotsSearched;																\
+portTickType xNextSlotTime;																		\
+																								\
+	xNextTaskUnblockTime = xTickCount + tskMAX_UNBLOCK_AHEAD;									\
+	xNextSlotTime = xTickCount;																	\
+	for( ucSlotsSearched = ( unsigned portCHAR ) 0; ucSlotsSearched < ( unsigned portCHAR ) portTIMING_WHEEL_SLOTS; ucSlotsSearched++ )	\
+	{																							\
+		++xNextSlotTime;																		\
+		if( !listLIST_IS_EMPTY( &( xTimingWheel[ xNextSlotTime & tskTIMING_WHEEL_MASK ] ) ) )	\
+		{																						\
+			xNextTaskUnblockTime = xNextSlotTime;												\
+			break;																				\
+		}																						\
+	}																							\
+}
+
+/*
+ * Macro that looks at the timing wheel slot for the current tick to see if
+ * any delayed tasks require waking, making ready no more than ucMaxWakes of
+ * them (0 for no limit).
+ *
+ * Ticks whose due tasks have not all been made ready are inspected again 
+ * along with the current tick.  Each slot need only be walked once however 
+ * many ticks are being checked, as the wake time of every task it holds is 
+ * compared against the whole range of ticks.  Should the limit be reached the
+ * next tick is processed by the kernel to carry on from the slot reached.
+ */
+#define prvCheckDelayedTasks( ucMaxWakes )														\
+{																								\
+portTickType xFirstTick, xTicks, xSlotTime;														\
+unsigned portCHAR ucSlotsToWalk, ucWoken;														\
+																								\
+	if( cDelayedTasksPending == ( signed portCHAR ) pdFALSE )									\
+	{																							\
+		xFirstTick = xTickCount;																\
+	}																							\
+	else																						\
+	{																							\
+		xFirstTick = xFirstPendingTick;															\
+	}																							\
+																								\
+	xTicks = ( portTickType ) ( xTickCount - xFirstTick ) + ( portTickType ) 1;					\
+	if( xTicks < ( portTickType ) portTIMING_WHEEL_SLOTS )										\
+	{																							\
+		ucSlotsToWalk = ( unsigned portCHAR ) xTicks;											\
+	}																							\
+	else																						\
+	{																							\
+		ucSlotsToWalk = ( unsigned portCHAR ) portTIMING_WHEEL_SLOTS;							\
+	}																							\
+																								\
+	ucWoken = ( unsigned portCHAR ) 0;															\
+	cDelayedTasksPending = pdFALSE;																\
+	xSlotTime = xFirstTick;																		\
+	while( ucSlotsToWalk > ( unsigned portCHAR ) 0 )											\
+	{																							\
+		prvWakeTasksInSlot( xSlotTime, xFirstTick, xTicks, ucWoken, ucMaxWakes );				\
+		if( prvWakeLimitReached( ucWoken, ucMaxWakes ) )										\
+		{																						\
+			cDelayedTasksPending = pdTRUE;														\
+			xFirstPendingTick = xSlotTime;														\
+			break;																				\
+		}																						\
+		++xSlotTime;																			\
+		--ucSlotsToWalk;																		\
+	}																							\
+																								\
+	if( cDelayedTasksPending == ( signed portCHAR ) pdFALSE )									\
+	{																							\
+		prvSetNextTaskUnblockTime();															\
+	}																							\
+	else																						\
+	{																							\
+		prvForceTickProcessing();																\
+	}																							\
+}
+
+#else
+
 /*
  * Macro that looks at the list of tasks that are currently delayed to see if 
  * any require waking.
  *
  * Tasks are stored in the queue in the order of their wake time - meaning
  * once one tasks has been found whose timer has not expired we need not look
- * any further down the list.
+ * any further down the list.  No more than ucMaxWakes tasks are made ready 
+ * (0 for no limit) - any others that are due remain at the head of the list
+ * and the next tick is processed by the kernel to carry on from there.
  */
-#define prvCheckDelayedTasks()																	\
+#define prvCheckDelayedTasks( ucMaxWakes )														\
 {																								\
-register tskTCB *pxTCB;																			\
+register tskTCB portOBJECT_SPACE *pxTCB;														\
+unsigned portCHAR ucWoken;																		\
 																								\
-	while( ( pxTCB = ( tskTCB * ) listGET_OWNER_OF_HEAD_ENTRY( pxDelayedTaskList ) ) != NULL )	\
+	ucWoken = ( unsigned portCHAR ) 0;															\
+	cDelayedTasksPending = pdFALSE;																\
+	while( ( pxTCB = ( tskTCB portOBJECT_SPACE * ) listGET_OWNER_OF_HEAD_ENTRY( pxDelayedTaskList ) ) != NULL )	\
 	{																							\
 		if( xTickCount < listGET_LIST_ITEM_VALUE( &( pxTCB->xGenericListItem ) ) )				\
 		{																						\
 			break;																				\
 		}																						\
+		if( prvWakeLimitReached( ucWoken, ucMaxWakes ) )										\
+		{																						\
+			cDelayedTasksPending = pdTRUE;														\
+			break;																				\
+		}																						\
 		vListRemove( &( pxTCB->xGenericListItem ) );											\
 		/* Is the task waiting on an event also? */												\
 		if( pxTCB->xEventListItem.pvContainer )													\
@@ -265,8 +668,96 @@ register tskTCB *pxTCB;																			\
 			vListRemove( &( pxTCB->xEventListItem ) );											\
 		}																						\
 		prvAddTaskToReadyQueue( pxTCB );														\
+		++ucWoken;																				\
+	}																							\
+																								\
+	/* Nothing need happen until the task now at the head of the list is due					\
+	to wake.  vTaskSwitchContext() will force the next tick to be processed					\
+	if time slicing is required. */																\
+	if( cDelayedTasksPending != ( signed portCHAR ) pdFALSE )									\
+	{																							\
+		prvForceTickProcessing();																\
+	}																							\
+	else if( pxTCB != NULL )																	\
+	{																							\
+		xNextTaskUnblockTime = listGET_LIST_ITEM_VALUE( &( pxTCB->xGenericListItem ) );			\
+		prvLimitNextTaskUnblockTime();															\
+	}																							\
+	else																						\
+	{																							\
+		xNextTaskUnblockTime = xTickCount + tskMAX_UNBLOCK_AHEAD;								\
 	}																							\
-}																							
+}
+
+#endif
+
+/*
+ * Macro called each time the tick count wraps to zero.  Swaps the delayed
+ * lists if they are in use and starts the next tick epoch if that is in use.
+ * A task delayed until the new epoch is made ready so it can complete its 
+ * delay on the delayed lists - see vTaskDelayLong().  Such tasks are rare and
+ * the tick only wraps once every 65536 ticks, so the unsorted long delay list
+ * is walked in full.  Any tasks left on the delayed list by the wake limit are
+ * all due, so are made ready before the list is retired.
+ */
+#if( USE_TIMING_WHEEL == 1 )
+
+	#define prvSwitchDelayedLists()
+
+#else
+
+	#define prvSwitchDelayedLists()																\
+	{																							\
+	volatile xList portOBJECT_SPACE *pxTemp;													\
+																								\
+		if( cDelayedTasksPending != ( signed portCHAR ) pdFALSE )								\
+		{																						\
+			xTickCount = portMAX_DELAY;															\
+			prvCheckDelayedTasks( 0 );															\
+			xTickCount = ( portTickType ) 0;													\
+		}																						\
+																								\
+		pxTemp = pxDelayedTaskList;																\
+		pxDelayedTaskList = pxOverflowDelayedTaskList;											\
+		pxOverflowDelayedTaskList = pxTemp;														\
+	}
+
+#endif
+
+#if( USE_TICK_EPOCH == 1 )
+
+	#define prvIncrementTickEpoch()																\
+	{																							\
+	register volatile xListItem portOBJECT_SPACE *pxItem;										\
+	volatile xListItem portOBJECT_SPACE *pxNextItem;											\
+	tskTCB portOBJECT_SPACE *pxTCB;																\
+																								\
+		++usTickEpoch;																			\
+		pxItem = xLongDelayTaskList.pxHead->pxNext;												\
+		while( pxItem != xLongDelayTaskList.pxHead )											\
+		{																						\
+			pxNextItem = pxItem->pxNext;														\
+			if( listGET_LIST_ITEM_VALUE( pxItem ) == ( portTickType ) usTickEpoch )				\
+			{																					\
+				pxTCB = ( tskTCB portOBJECT_SPACE * ) pxItem->pvOwner;							\
+				vListRemove( &( pxTCB->xGenericListItem ) );									\
+				prvAddTaskToReadyQueue( pxTCB );												\
+			}																					\
+			pxItem = pxNextItem;																\
+		}																						\
+	}
+
+#else
+
+	#define prvIncrementTickEpoch()
+
+#endif
+
+#define prvTickCountOverflowed()																\
+{																								\
+	prvSwitchDelayedLists();																	\
+	prvIncrementTickEpoch();																	\
+}
 
 /*
  * Several functions take an xTaskHandle parameter that can optionally be NULL,
@@ -274,7 +765,7 @@ register tskTCB *pxTCB;																			\
  * task should be used in place of the parameter.  This macro simply checks to 
  * see if the parameter is NULL and returns a pointer to the appropriate TCB.
  */
-#define prvGetTCBFromHandle( pxHandle ) ( ( pxHandle == NULL ) ? ( tskTCB * ) pxCurrentTCB : ( tskTCB * ) pxHandle )
+#define prvGetTCBFromHandle( pxHandle ) ( ( pxHandle == NULL ) ? ( tskTCB portOBJECT_SPACE * ) pxCurrentTCB : ( tskTCB portOBJECT_SPACE * ) pxHandle )
 
 
 /* File private functions. --------------------------------*/
@@ -283,7 +774,7 @@ register tskTCB *pxTCB;																			\
  * Utility to ready a TCB for a given task.  Mainly just copies the parameters
  * into the TCB structure.
  */
-static void prvInitialiseTCBVariables( tskTCB *pxTCB, unsigned portSHORT usStackDepth, const signed portCHAR * const pcName, unsigned portCHAR ucPriority );
+static void prvInitialiseTCBVariables( tskTCB portOBJECT_SPACE *pxTCB, unsigned portSHORT usStackDepth, const signed portCHAR * const pcName, unsigned portCHAR ucPriority );
 
 /*
  * Utility to ready all the lists used by the scheduler.  This is called 
@@ -305,7 +796,7 @@ static void prvIdleTask( void *pvParameters );
  * This does not free memory allocated by the task itself (i.e. memory 
  * allocated by calls to pvPortMalloc from within the tasks application code).
  */
-static void prvDeleteTCB( tskTCB *pxTCB );
+static void prvDeleteTCB( tskTCB portOBJECT_SPACE *pxTCB );
 
 /*
  * Used only by the idle task.  This checks to see if anything has been placed
@@ -314,11 +805,44 @@ static void prvDeleteTCB( tskTCB *pxTCB );
  */
 static void prvCheckTasksWaitingTermination( void );
 
+/*
+ * Places the calling task, which must already have been removed from its
+ * ready list, in the delayed task list(s) to be woken at xTimeToWake.  MUST
+ * BE CALLED WITH INTERRUPTS DISABLED OR THE SCHEDULER SUSPENDED.
+ */
+static void prvAddCurrentTaskToDelayedList( portTickType xTimeToWake );
+
+/*
+ * Moves the tick count forward by xTicksToAdvance ticks in one step, waking
+ * every delayed task whose wake time has been reached.  Used to process the
+ * ticks that were missed while the scheduler was suspended.  MUST BE CALLED
+ * WITH INTERRUPTS DISABLED AND THE SCHEDULER NOT SUSPENDED.
+ */
+static void prvAdvanceTickCount( portTickType xTicksToAdvance );
+
+/*
+ * Updates the notification value of pxTCB as set out by ucAction and, if the
+ * task was waiting for a notification, makes it ready - or places it in the
+ * pending ready list if the scheduler is suspended.  *pcTaskWoken is set to
+ * pdTRUE if the task has a higher priority than the calling task.  Used by
+ * both cTaskNotify() and cTaskNotifyFromISR().  MUST BE CALLED WITH 
+ * INTERRUPTS DISABLED OR FROM AN ISR.
+ */
+#if( USE_TASK_NOTIFICATIONS == 1 )
+	static signed portCHAR prvTaskNotify( tskTCB portOBJECT_SPACE *pxTCB, unsigned portLONG ulValue, unsigned portCHAR ucAction, signed portCHAR *pcTaskWoken );
+#endif
+
 /*
  * Allocates memory from the heap for a TCB and associated stack.  Checks the
  * allocation was successful.
  */
-static tskTCB *prvAllocateTCBAndStack( unsigned portSHORT usStackDepth );
+static tskTCB portOBJECT_SPACE *prvAllocateTCBAndStack( unsigned portSHORT usStackDepth );
+
+/*
+ * Implements both sTaskCreate() and sTaskCreateResident().  ucStackSlot is
+ * portNO_STACK_SLOT if the task stack is to be allocated from the heap.
+ */
+static portSHORT prvTaskCreate( pdTASK_CODE pvTaskCode, const signed portCHAR * const pcName, unsigned portSHORT usStackDepth, void *pvParameters, unsigned portCHAR ucPriority, unsigned portCHAR ucStackSlot, xTaskHandle *pxCreatedTask );
 
 /*
  * Called from vTaskList.  vListTasks details all the tasks currently under
@@ -331,7 +855,17 @@ static tskTCB *prvAllocateTCBAndStack( unsigned portSHORT usStackDepth );
  */
 #if( USE_TRACE_FACILITY == 1 )
 
-	static void prvListTaskWithinSingleList( signed portCHAR *pcWriteBuffer, xList *pxList, signed portCHAR cStatus );
+	static void prvListTaskWithinSingleList( signed portCHAR *pcWriteBuffer, xList portOBJECT_SPACE *pxList, signed portCHAR cStatus );
+#endif
+
+/*
+ * Returns the number of bytes at the far end of the stack of pxTCB that still
+ * hold tskSTACK_FILL_BYTE, or zero if the task has a resident stack slot.
+ */
+#if( USE_TRACE_FACILITY == 1 )
+
+	static unsigned portSHORT prvTaskFreeStackSpace( const tskTCB portOBJECT_SPACE *pxTCB );
+
 #endif
 
 
@@ -346,10 +880,32 @@ static tskTCB *prvAllocateTCBAndStack( unsigned portSHORT usStackDepth );
  *----------------------------------------------------------*/
 
 portSHORT sTaskCreate( pdTASK_CODE pvTaskCode, const signed portCHAR * const pcName, unsigned portSHORT usStackDepth, void *pvParameters, unsigned portCHAR ucPriority, xTaskHandle *pxCreatedTask )
+{
+	return prvTaskCreate( pvTaskCode, pcName, usStackDepth, pvParameters, ucPriority, ( unsigned portCHAR ) portNO_STACK_SLOT, pxCreatedTask );
+}
+/*-----------------------------------------------------------*/
+
+#if( portNUM_STACK_SLOTS > 0 )
+
+	portSHORT sTaskCreateResident( pdTASK_CODE pvTaskCode, const signed portCHAR * const pcName, void *pvParameters, unsigned portCHAR ucPriority, unsigned portCHAR ucStackSlot, xTaskHandle *pxCreatedTask )
+	{
+		if( ucStackSlot >= ( unsigned portCHAR ) portNUM_STACK_SLOTS )
+		{
+			return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+		}
+
+		/* The stack lives in the slot, so none is allocated from the heap. */
+		return prvTaskCreate( pvTaskCode, pcName, ( unsigned portSHORT ) 0, pvParameters, ucPriority, ucStackSlot, pxCreatedTask );
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+static portSHORT prvTaskCreate( pdTASK_CODE pvTaskCode, const signed portCHAR * const pcName, unsigned portSHORT usStackDepth, void *pvParameters, unsigned portCHAR ucPriority, unsigned portCHAR ucStackSlot, xTaskHandle *pxCreatedTask )
 {
 portSHORT sReturn;
-tskTCB * pxNewTCB;
-static unsigned portCHAR ucTaskNumber = 0; /*lint !e956 Static is deliberate - this is guarded before use. */
+tskTCB portOBJECT_SPACE * pxNewTCB;
+static unsigned portCHAR portKERNEL_DATA ucTaskNumber = 0; /*lint !e956 Static is deliberate - this is guarded before use. */
 
 	/* Allocate the memory required by the TCB and stack for the new task.  
 	checking that the allocation was successful. */
@@ -361,6 +917,17 @@ static unsigned portCHAR ucTaskNumber = 0; /*lint !e956 Static is deliberate - t
 		/* Setup the newly allocated TCB with the initial state of the task. */
 		prvInitialiseTCBVariables( pxNewTCB, usStackDepth, pcName, ucPriority );
 
+		#if( portNUM_STACK_SLOTS > 0 )
+		{
+			pxNewTCB->ucStackSlot = ucStackSlot;
+		}
+		#else
+		{
+			/* Only tasks using a heap stack can be created. */
+			( void ) ucStackSlot;
+		}
+		#endif
+
 		/* Calculate the top of stack address.  This depends on whether the
 		stack grows from high memory to low (as per the 80x86) or visa versa. 
 		portSTACK_GROWTH is used to make the result positive or negative as
@@ -381,8 +948,25 @@ static unsigned portCHAR ucTaskNumber = 0; /*lint !e956 Static is deliberate - t
 		/* Initialise the TCB stack to look as if the task was already running,
 		but had been interrupted by the scheduler.  The return address is set
 		to the start of the task function. Once the stack has been initialised
-		the	top of stack variable is updated. */
-		pxNewTCB->pxTopOfStack = pxPortInitialiseStack( pxTopOfStack, pvTaskCode, pvParameters );
+		the	top of stack variable is updated.  A task with a resident stack
+		slot has its context placed directly into the slot. */
+		#if( portNUM_STACK_SLOTS > 0 )
+		{
+			if( ucStackSlot != ( unsigned portCHAR ) portNO_STACK_SLOT )
+			{
+				vPortInitialiseStackSlot( ucStackSlot, pvTaskCode, pvParameters );
+				pxNewTCB->pxTopOfStack = NULL;
+			}
+			else
+			{
+				pxNewTCB->pxTopOfStack = pxPortInitialiseStack( pxTopOfStack, pvTaskCode, pvParameters );
+			}
+		}
+		#else
+		{
+			pxNewTCB->pxTopOfStack = pxPortInitialiseStack( pxTopOfStack, pvTaskCode, pvParameters );
+		}
+		#endif
 
 		/* We are going to manipulate the task queues to add this task to a
 		ready list, so must make sure no interrupts occur. */
@@ -392,7 +976,7 @@ static unsigned portCHAR ucTaskNumber = 0; /*lint !e956 Static is deliberate - t
 			if( usCurrentNumberOfTasks == ( unsigned portSHORT ) 1 )
 			{
 				/* As this is the first task it must also be the current task. */
-				pxCurrentTCB = ( volatile tskTCB * volatile ) pxNewTCB;
+				pxCurrentTCB = ( volatile tskTCB portOBJECT_SPACE * volatile ) pxNewTCB;
 
 				/* This is the first task to be created so do the preliminary
 				initialisation required.  We will not recover if this call 
@@ -410,7 +994,7 @@ static unsigned portCHAR ucTaskNumber = 0; /*lint !e956 Static is deliberate - t
 				{
 					if( pxCurrentTCB->ucPriority <= ucPriority )
 					{
-						pxCurrentTCB = ( volatile tskTCB * volatile ) pxNewTCB;	
+						pxCurrentTCB = ( volatile tskTCB portOBJECT_SPACE * volatile ) pxNewTCB;	
 					}
 				}
 			}				
@@ -464,7 +1048,7 @@ static unsigned portCHAR ucTaskNumber = 0; /*lint !e956 Static is deliberate - t
 
 	void vTaskDelete( xTaskHandle pxTaskToDelete )
 	{
-	tskTCB *pxTCB;
+	tskTCB portOBJECT_SPACE *pxTCB;
 
 		taskENTER_CRITICAL();
 		{
@@ -476,6 +1060,7 @@ static unsigned portCHAR ucTaskNumber = 0; /*lint !e956 Static is deliberate - t
 			the termination list and free up any memory allocated by the 
 			scheduler for the TCB and stack. */
 			vListRemove( &( pxTCB->xGenericListItem ) );
+			prvResetReadyPriority( pxTCB->ucPriority );
 
 			/* Is the task waiting on an event also? */												
 			if( pxTCB->xEventListItem.pvContainer )
@@ -483,7 +1068,7 @@ static unsigned portCHAR ucTaskNumber = 0; /*lint !e956 Static is deliberate - t
 				vListRemove( &( pxTCB->xEventListItem ) );
 			}
 
-			vListInsertEnd( ( xList * ) &xTasksWaitingTermination, &( pxTCB->xGenericListItem ) );
+			vListInsertEnd( ( xList portOBJECT_SPACE * ) &xTasksWaitingTermination, &( pxTCB->xGenericListItem ) );
 		}
 		taskEXIT_CRITICAL();
 
@@ -529,21 +1114,10 @@ signed portCHAR cAlreadyYielded = pdFALSE;
 			/* We must remove ourselves from the ready list before adding 
 			ourselves to the blocked list as the same list item is used for 
 			both lists. */
-			vListRemove( ( xListItem * ) &( pxCurrentTCB->xGenericListItem ) );
+			vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxCurrentTCB->xGenericListItem ) );
+			prvResetReadyPriority( pxCurrentTCB->ucPriority );
 
-			/* The list item will be inserted in wake time order. */
-			listSET_LIST_ITEM_VALUE( &( pxCurrentTCB->xGenericListItem ), xTimeToWake );
-
-			if( xTimeToWake < xTickCount )
-			{
-				/* Wake time has overflowed.  Place this item in the overflow list. */
-				vListInsert( ( xList * ) pxOverflowDelayedTaskList, ( xListItem * ) &( pxCurrentTCB->xGenericListItem ) );
-			}
-			else
-			{
-				/* The wake time has not overflowed, so we can use the current block list. */
-				vListInsert( ( xList * ) pxDelayedTaskList, ( xListItem * ) &( pxCurrentTCB->xGenericListItem ) );
-			}
+			prvAddCurrentTaskToDelayedList( xTimeToWake );
 		}
 		cAlreadyYielded = cTaskResumeAll();
 	}
@@ -557,33 +1131,169 @@ signed portCHAR cAlreadyYielded = pdFALSE;
 }
 /*-----------------------------------------------------------*/
 
-#if( INCLUDE_ucTaskPriorityGet == 1 )
+#if( INCLUDE_cTaskDelayUntil == 1 )
 
-	unsigned portCHAR ucTaskPriorityGet( xTaskHandle pxTask )
+	signed portCHAR cTaskDelayUntil( portTickType *pxPreviousWakeTime, portTickType xTimeIncrement )
 	{
-	tskTCB *pxTCB;
-	unsigned portCHAR ucReturn;
+	portTickType xTimeToWake;
+	signed portCHAR cAlreadyYielded, cShouldDelay = ( signed portCHAR ) pdFALSE, cOnTime;
 
-		taskENTER_CRITICAL();
+		vTaskSuspendAll();
 		{
-			/* If null is passed in here then we are changing the
-			priority of the calling function. */
-			pxTCB = prvGetTCBFromHandle( pxTask );
-			ucReturn = pxTCB->ucPriority;
-		}
-		taskEXIT_CRITICAL();
-
-		return ucReturn;
-	}
+			/* The tick count cannot change while the scheduler is suspended.
+			Generate the tick time at which the task wants to wake - this may 
+			overflow but this is not a problem. */
+			xTimeToWake = *pxPreviousWakeTime + xTimeIncrement;
 
-#endif
-/*-----------------------------------------------------------*/
-
-#if( INCLUDE_vTaskPrioritySet == 1 )
+			if( xTickCount < *pxPreviousWakeTime )
+			{
+				/* The tick count has overflowed since this function was 
+				last called.  In this case the only time we should ever
+				actually delay is if the wake time has also overflowed,
+				and the wake time is greater than the tick time.  When this
+				is the case it is as if neither time had overflowed. */
+				if( ( xTimeToWake < *pxPreviousWakeTime ) && ( xTimeToWake > xTickCount ) )
+				{
+					cShouldDelay = ( signed portCHAR ) pdTRUE;
+				}
+			}
+			else
+			{
+				/* The tick time has not overflowed.  In this case we will
+				delay if either the wake time has overflowed, and/or the
+				tick time is less than the wake time. */
+				if( ( xTimeToWake < *pxPreviousWakeTime ) || ( xTimeToWake > xTickCount ) )
+				{
+					cShouldDelay = ( signed portCHAR ) pdTRUE;
+				}
+			}
+
+			/* A release that falls due on this very tick is on time, although
+			there is nothing to wait for.  Only one that has already passed is 
+			reported as missed. */
+			if( cShouldDelay || ( xTimeToWake == xTickCount ) )
+			{
+				cOnTime = ( signed portCHAR ) pdTRUE;
+			}
+			else
+			{
+				cOnTime = ( signed portCHAR ) pdFALSE;
+			}
+
+			/* Update the wake time ready for the next call.  This is done
+			even if the release has been missed, so the period does not
+			drift. */
+			*pxPreviousWakeTime = xTimeToWake;
+
+			if( cShouldDelay )
+			{
+				/* We must remove ourselves from the ready list before adding 
+				ourselves to the blocked list as the same list item is used for 
+				both lists. */
+				vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxCurrentTCB->xGenericListItem ) );
+				prvResetReadyPriority( pxCurrentTCB->ucPriority );
+
+				prvAddCurrentTaskToDelayedList( xTimeToWake );
+			}
+		}
+		cAlreadyYielded = cTaskResumeAll();
+
+		/* Force a reschedule if cTaskResumeAll has not already done so, we 
+		may have put ourselves to sleep. */
+		if( !cAlreadyYielded )
+		{
+			taskYIELD(); 
+		}
+
+		return cOnTime;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( USE_TICK_EPOCH == 1 )
+
+	void vTaskDelayLong( unsigned portLONG ulTicksToDelay )
+	{
+	unsigned portLONG ulTimeToWake;
+	unsigned portSHORT usEpochToWake;
+	portTickType xTimeToWake;
+
+		vTaskSuspendAll();
+		{
+			/* The tick count and epoch cannot change while the scheduler is
+			suspended.  Calculate the extended time to wake - this may 
+			overflow but this is not a problem. */
+			ulTimeToWake = ( ( ( unsigned portLONG ) usTickEpoch ) << 16 ) + ( unsigned portLONG ) xTickCount + ulTicksToDelay;
+			usEpochToWake = ( unsigned portSHORT ) ( ulTimeToWake >> 16 );
+			xTimeToWake = ( portTickType ) ulTimeToWake;
+
+			if( usEpochToWake != usTickEpoch )
+			{
+				/* The wake time is beyond the current epoch.  Wait on the 
+				long delay list until the epoch in which the task is to wake
+				starts.  We must remove ourselves from the ready list first as
+				the same list item is used for both lists. */
+				vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxCurrentTCB->xGenericListItem ) );
+				prvResetReadyPriority( pxCurrentTCB->ucPriority );
+
+				listSET_LIST_ITEM_VALUE( &( pxCurrentTCB->xGenericListItem ), ( portTickType ) usEpochToWake );
+				vListInsertEnd( ( xList portOBJECT_SPACE * ) &xLongDelayTaskList, ( xListItem portOBJECT_SPACE * ) &( pxCurrentTCB->xGenericListItem ) );
+			}
+		}
+		if( !cTaskResumeAll() )
+		{
+			taskYIELD();
+		}
+
+		/* The task is now within the epoch in which it is to wake, so the
+		remainder of the delay is an ordinary 16 bit delay. */
+		vTaskSuspendAll();
+		{
+			if( ( usTickEpoch == usEpochToWake ) && ( xTickCount < xTimeToWake ) )
+			{
+				vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxCurrentTCB->xGenericListItem ) );
+				prvResetReadyPriority( pxCurrentTCB->ucPriority );
+
+				prvAddCurrentTaskToDelayedList( xTimeToWake );
+			}
+		}
+		if( !cTaskResumeAll() )
+		{
+			taskYIELD();
+		}
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( INCLUDE_ucTaskPriorityGet == 1 )
+
+	unsigned portCHAR ucTaskPriorityGet( xTaskHandle pxTask )
+	{
+	tskTCB portOBJECT_SPACE *pxTCB;
+	unsigned portCHAR ucReturn;
+
+		taskENTER_CRITICAL();
+		{
+			/* If null is passed in here then we are changing the
+			priority of the calling function. */
+			pxTCB = prvGetTCBFromHandle( pxTask );
+			ucReturn = pxTCB->ucPriority;
+		}
+		taskEXIT_CRITICAL();
+
+		return ucReturn;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( INCLUDE_vTaskPrioritySet == 1 )
 
 	void vTaskPrioritySet( xTaskHandle pxTask, unsigned portCHAR ucNewPriority )
 	{
-	tskTCB *pxTCB;
+	tskTCB portOBJECT_SPACE *pxTCB;
 	unsigned portCHAR ucCurrentPriority;
 
 		/* Ensure the new priority is valid. */
@@ -612,6 +1322,7 @@ signed portCHAR cAlreadyYielded = pdFALSE;
 					/* The task is currently in its ready list - remove before adding
 					it to it's new ready list. */
 					vListRemove( &( pxTCB->xGenericListItem ) );
+					prvResetReadyPriority( ucCurrentPriority );
 					prvAddTaskToReadyQueue( pxTCB );
 				}			
 			}
@@ -630,7 +1341,7 @@ signed portCHAR cAlreadyYielded = pdFALSE;
 
 	void vTaskSuspend( xTaskHandle pxTaskToSuspend )
 	{
-	tskTCB *pxTCB;
+	tskTCB portOBJECT_SPACE *pxTCB;
 
 		taskENTER_CRITICAL();
 		{
@@ -639,6 +1350,7 @@ signed portCHAR cAlreadyYielded = pdFALSE;
 
 			/* Remove task from the ready/delayed list and place in the	suspended list. */
 			vListRemove( &( pxTCB->xGenericListItem ) );
+			prvResetReadyPriority( pxTCB->ucPriority );
 
 			/* Is the task waiting on an event also? */												
 			if( pxTCB->xEventListItem.pvContainer )
@@ -646,7 +1358,7 @@ signed portCHAR cAlreadyYielded = pdFALSE;
 				vListRemove( &( pxTCB->xEventListItem ) );
 			}
 
-			vListInsertEnd( ( xList * ) &xSuspendedTaskList, &( pxTCB->xGenericListItem ) );
+			vListInsertEnd( ( xList portOBJECT_SPACE * ) &xSuspendedTaskList, &( pxTCB->xGenericListItem ) );
 		}
 		taskEXIT_CRITICAL();
 
@@ -664,12 +1376,12 @@ signed portCHAR cAlreadyYielded = pdFALSE;
 
 	void vTaskResume( xTaskHandle pxTaskToResume )
 	{
-	tskTCB *pxTCB;
+	tskTCB portOBJECT_SPACE *pxTCB;
 	portSHORT sYieldRequired;
 
 		/* Remove the task from whichever list it is currently in, and place
 		it in the ready list. */
-		pxTCB = ( tskTCB * ) pxTaskToResume;
+		pxTCB = ( tskTCB portOBJECT_SPACE * ) pxTaskToResume;
 
 		/* The parameter cannot be NULL as it is impossible to resume the
 		currently executing task. */
@@ -706,8 +1418,19 @@ signed portCHAR cAlreadyYielded = pdFALSE;
 
 void vTaskStartScheduler( portSHORT sUsePreemption )
 {
+portSHORT sReturn = pdPASS;
+
+	#if( USE_TIMERS == 1 )
+	{
+		/* The timer task is created whether or not any timers have been
+		created yet, as timers can also be created once the scheduler is
+		running. */
+		sReturn = sTimerCreateTimerTask();
+	}
+	#endif
+
 	/* Check a task has been created. */
-	if( pxCurrentTCB != NULL )
+	if( ( pxCurrentTCB != NULL ) && ( sReturn == pdPASS ) )
 	{
 		sUsingPreemption = sUsePreemption;
 
@@ -723,6 +1446,7 @@ void vTaskStartScheduler( portSHORT sUsePreemption )
 
 		cSchedulerRunning = pdTRUE;
 		xTickCount = ( portTickType ) 0;
+		prvForceTickProcessing();
 
 		/* Setting up the timer tick is hardware specific and thus in the 
 		portable interface. */
@@ -754,13 +1478,17 @@ void vTaskSuspendAll( void )
 {
 	portENTER_CRITICAL();
 		++ucSchedulerSuspended;
+
+		/* Ticks that occur while the scheduler is suspended must be counted
+		by vTaskIncrementTick() as missed ticks. */
+		prvForceTickProcessing();
 	portEXIT_CRITICAL();
 }
 /*----------------------------------------------------------*/
 
 signed portCHAR cTaskResumeAll( void )
 {
-register tskTCB *pxTCB;
+register tskTCB portOBJECT_SPACE *pxTCB;
 signed portCHAR cAlreadyYielded = ( signed portCHAR ) pdFALSE;
 
 	/* It is possible that an ISR caused a task to be removed from an event
@@ -776,7 +1504,7 @@ signed portCHAR cAlreadyYielded = ( signed portCHAR ) pdFALSE;
 		{
 			/* Move any readied tasks from the pending list into the 
 			appropriate ready list. */
-			while( ( pxTCB = ( tskTCB * ) listGET_OWNER_OF_HEAD_ENTRY(  ( ( xList * ) &xPendingReadyList ) ) ) != NULL )
+			while( ( pxTCB = ( tskTCB portOBJECT_SPACE * ) listGET_OWNER_OF_HEAD_ENTRY(  ( ( xList portOBJECT_SPACE * ) &xPendingReadyList ) ) ) != NULL )
 			{
 				vListRemove( &( pxTCB->xEventListItem ) );
 				vListRemove( &( pxTCB->xGenericListItem ) );
@@ -786,13 +1514,10 @@ signed portCHAR cAlreadyYielded = ( signed portCHAR ) pdFALSE;
 			/* If any ticks occurred while the scheduler was suspended then
 			they should be processed now.  This ensures the tick count does not
 			slip, and that any delayed tasks are resumed at the correct time. */
-			if( ucMissedTicks > 0 )
+			if( xMissedTicks > ( portTickType ) 0 )
 			{
-				while( ucMissedTicks > 0 )
-				{
-					vTaskIncrementTick();
-					--ucMissedTicks;
-				}
+				prvAdvanceTickCount( xMissedTicks );
+				xMissedTicks = ( portTickType ) 0;
 
 				/* As we have processed some ticks it is appropriate to yield
 				to ensure the highest priority task that is ready to run is
@@ -833,6 +1558,24 @@ portTickType xTicks;
 }
 /*-----------------------------------------------------------*/
 
+#if( USE_TICK_EPOCH == 1 )
+
+	unsigned portLONG ulTaskGetExtendedTickCount( void )
+	{
+	unsigned portLONG ulTicks;
+
+		taskENTER_CRITICAL();
+		{
+			ulTicks = ( ( ( unsigned portLONG ) usTickEpoch ) << 16 ) | ( unsigned portLONG ) xTickCount;
+		}
+		taskEXIT_CRITICAL();
+
+		return ulTicks;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
 unsigned portSHORT usTaskGetNumberOfTasks( void )
 {
 unsigned portSHORT usNumberOfTasks;
@@ -870,28 +1613,51 @@ unsigned portSHORT usNumberOfTasks;
 
 				if( !listLIST_IS_EMPTY( &( pxReadyTasksLists[ usQueue ] ) ) )
 				{
-					prvListTaskWithinSingleList( pcWriteBuffer, ( xList * ) &( pxReadyTasksLists[ usQueue ] ), tskREADY_CHAR );			
+					prvListTaskWithinSingleList( pcWriteBuffer, ( xList portOBJECT_SPACE * ) &( pxReadyTasksLists[ usQueue ] ), tskREADY_CHAR );			
 				}
 			}while( usQueue > ( unsigned portSHORT ) tskIDLE_PRIORITY );
 
-			if( !listLIST_IS_EMPTY( pxDelayedTaskList ) )
+			#if( USE_TIMING_WHEEL == 1 )
 			{
-				prvListTaskWithinSingleList( pcWriteBuffer, ( xList * ) pxDelayedTaskList, tskBLOCKED_CHAR );
+				for( usQueue = ( unsigned portSHORT ) 0; usQueue < ( unsigned portSHORT ) portTIMING_WHEEL_SLOTS; usQueue++ )
+				{
+					if( !listLIST_IS_EMPTY( &( xTimingWheel[ usQueue ] ) ) )
+					{
+						prvListTaskWithinSingleList( pcWriteBuffer, ( xList portOBJECT_SPACE * ) &( xTimingWheel[ usQueue ] ), tskBLOCKED_CHAR );
+					}
+				}
+			}
+			#else
+			{
+				if( !listLIST_IS_EMPTY( pxDelayedTaskList ) )
+				{
+					prvListTaskWithinSingleList( pcWriteBuffer, ( xList portOBJECT_SPACE * ) pxDelayedTaskList, tskBLOCKED_CHAR );
+				}
+
+				if( !listLIST_IS_EMPTY( pxOverflowDelayedTaskList ) )
+				{
+					prvListTaskWithinSingleList( pcWriteBuffer, ( xList portOBJECT_SPACE * ) pxOverflowDelayedTaskList, tskBLOCKED_CHAR );
+				}
 			}
+			#endif
 
-			if( !listLIST_IS_EMPTY( pxOverflowDelayedTaskList ) )
+			#if( USE_TICK_EPOCH == 1 )
 			{
-				prvListTaskWithinSingleList( pcWriteBuffer, ( xList * ) pxOverflowDelayedTaskList, tskBLOCKED_CHAR );
+				if( !listLIST_IS_EMPTY( &xLongDelayTaskList ) )
+				{
+					prvListTaskWithinSingleList( pcWriteBuffer, ( xList portOBJECT_SPACE * ) &xLongDelayTaskList, tskBLOCKED_CHAR );
+				}
 			}
+			#endif
 
 			if( !listLIST_IS_EMPTY( &xTasksWaitingTermination ) )
 			{
-				prvListTaskWithinSingleList( pcWriteBuffer, ( xList * ) &xTasksWaitingTermination, tskDELETED_CHAR );
+				prvListTaskWithinSingleList( pcWriteBuffer, ( xList portOBJECT_SPACE * ) &xTasksWaitingTermination, tskDELETED_CHAR );
 			}
 
 			if( !listLIST_IS_EMPTY( &xSuspendedTaskList ) )
 			{
-				prvListTaskWithinSingleList( pcWriteBuffer, ( xList * ) &xSuspendedTaskList, tskSUSPENDED_CHAR );
+				prvListTaskWithinSingleList( pcWriteBuffer, ( xList portOBJECT_SPACE * ) &xSuspendedTaskList, tskSUSPENDED_CHAR );
 			}
 		}
 		taskEXIT_CRITICAL();
@@ -933,6 +1699,253 @@ unsigned portSHORT usNumberOfTasks;
 	}
 
 #endif
+/*----------------------------------------------------------*/
+
+#if( USE_TRACE_FACILITY == 1 )
+
+	void vTaskGetStackUsage( xTaskHandle pxTask, unsigned portSHORT *pusMaxStackBytes, unsigned portSHORT *pusFreeStackSpace )
+	{
+	tskTCB portOBJECT_SPACE *pxTCB;
+
+		pxTCB = prvGetTCBFromHandle( pxTask );
+
+		/* The stack is only scanned, so need not be protected, but the depth 
+		is updated by the port when the task is switched out. */
+		portENTER_CRITICAL();
+			*pusMaxStackBytes = ( unsigned portSHORT ) pxTCB->ucMaxStackBytes;
+		portEXIT_CRITICAL();
+
+		*pusFreeStackSpace = prvTaskFreeStackSpace( pxTCB );
+	}
+
+#endif
+
+
+
+
+
+
+
+/*-----------------------------------------------------------
+ * TASK NOTIFICATION API documented in task.h
+ *----------------------------------------------------------*/
+
+#if( USE_TASK_NOTIFICATIONS == 1 )
+
+	signed portCHAR cTaskNotify( xTaskHandle pxTaskToNotify, unsigned portLONG ulValue, unsigned portCHAR ucAction )
+	{
+	signed portCHAR cReturn, cTaskWoken = ( signed portCHAR ) pdFALSE;
+
+		taskENTER_CRITICAL();
+		{
+			cReturn = prvTaskNotify( ( tskTCB portOBJECT_SPACE * ) pxTaskToNotify, ulValue, ucAction, &cTaskWoken );
+		}
+		taskEXIT_CRITICAL();
+
+		/* If the scheduler is suspended the task will not be made ready until
+		the scheduler is resumed. */
+		if( ( cTaskWoken != ( signed portCHAR ) pdFALSE ) && ( ucSchedulerSuspended == ( unsigned portCHAR ) pdFALSE ) )
+		{
+			taskYIELD();
+		}
+
+		return cReturn;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( USE_TASK_NOTIFICATIONS == 1 )
+
+	signed portCHAR cTaskNotifyFromISR( xTaskHandle pxTaskToNotify, unsigned portLONG ulValue, unsigned portCHAR ucAction, signed portCHAR *pcTaskWoken )
+	{
+		/* As cTaskRemoveFromEventList(), this only accesses the ready lists
+		if the scheduler is not suspended. */
+		return prvTaskNotify( ( tskTCB portOBJECT_SPACE * ) pxTaskToNotify, ulValue, ucAction, pcTaskWoken );
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( USE_TASK_NOTIFICATIONS == 1 )
+
+	signed portCHAR cTaskNotifyWait( unsigned portLONG ulBitsToClearOnEntry, unsigned portLONG ulBitsToClearOnExit, unsigned portLONG *pulNotificationValue, portTickType xTicksToWait )
+	{
+	signed portCHAR cReturn;
+
+		taskENTER_CRITICAL();
+		{
+			/* Only block if a notification is not already pending. */
+			if( pxCurrentTCB->ucNotifyState != tskNOTIFICATION_RECEIVED )
+			{
+				pxCurrentTCB->ulNotifiedValue &= ~ulBitsToClearOnEntry;
+				pxCurrentTCB->ucNotifyState = tskWAITING_NOTIFICATION;
+
+				if( xTicksToWait > ( portTickType ) 0 )
+				{
+					/* The task is not placed in an event list - a notification
+					finds it through its handle.  Interrupts are disabled so
+					the task cannot be notified before it is in the delayed 
+					list. */
+					vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxCurrentTCB->xGenericListItem ) );
+					prvResetReadyPriority( pxCurrentTCB->ucPriority );
+					prvAddCurrentTaskToDelayedList( xTickCount + xTicksToWait );
+
+					/* The task runs again once it is notified or the timeout
+					expires. */
+					taskYIELD();
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		taskENTER_CRITICAL();
+		{
+			if( pulNotificationValue != NULL )
+			{
+				*pulNotificationValue = pxCurrentTCB->ulNotifiedValue;
+			}
+
+			/* If the state is still tskWAITING_NOTIFICATION the wait timed 
+			out. */
+			if( pxCurrentTCB->ucNotifyState == tskNOTIFICATION_RECEIVED )
+			{
+				pxCurrentTCB->ulNotifiedValue &= ~ulBitsToClearOnExit;
+				cReturn = ( signed portCHAR ) pdTRUE;
+			}
+			else
+			{
+				cReturn = ( signed portCHAR ) pdFALSE;
+			}
+
+			pxCurrentTCB->ucNotifyState = tskNOT_WAITING_NOTIFICATION;
+		}
+		taskEXIT_CRITICAL();
+
+		return cReturn;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( USE_TASK_NOTIFICATIONS == 1 )
+
+	unsigned portLONG ulTaskNotifyTake( signed portCHAR cClearCountOnExit, portTickType xTicksToWait )
+	{
+	unsigned portLONG ulReturn;
+
+		taskENTER_CRITICAL();
+		{
+			/* Only block if the notification count is not already non-zero. */
+			if( pxCurrentTCB->ulNotifiedValue == ( unsigned portLONG ) 0 )
+			{
+				pxCurrentTCB->ucNotifyState = tskWAITING_NOTIFICATION;
+
+				if( xTicksToWait > ( portTickType ) 0 )
+				{
+					/* See cTaskNotifyWait(). */
+					vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxCurrentTCB->xGenericListItem ) );
+					prvResetReadyPriority( pxCurrentTCB->ucPriority );
+					prvAddCurrentTaskToDelayedList( xTickCount + xTicksToWait );
+					taskYIELD();
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		taskENTER_CRITICAL();
+		{
+			ulReturn = pxCurrentTCB->ulNotifiedValue;
+
+			if( ulReturn != ( unsigned portLONG ) 0 )
+			{
+				if( cClearCountOnExit != ( signed portCHAR ) pdFALSE )
+				{
+					pxCurrentTCB->ulNotifiedValue = ( unsigned portLONG ) 0;
+				}
+				else
+				{
+					pxCurrentTCB->ulNotifiedValue = ulReturn - ( unsigned portLONG ) 1;
+				}
+			}
+
+			pxCurrentTCB->ucNotifyState = tskNOT_WAITING_NOTIFICATION;
+		}
+		taskEXIT_CRITICAL();
+
+		return ulReturn;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( USE_TASK_NOTIFICATIONS == 1 )
+
+	static signed portCHAR prvTaskNotify( tskTCB portOBJECT_SPACE *pxTCB, unsigned portLONG ulValue, unsigned portCHAR ucAction, signed portCHAR *pcTaskWoken )
+	{
+	unsigned portCHAR ucOriginalState;
+	signed portCHAR cReturn = ( signed portCHAR ) pdPASS;
+
+		ucOriginalState = pxTCB->ucNotifyState;
+		pxTCB->ucNotifyState = tskNOTIFICATION_RECEIVED;
+
+		switch( ucAction )
+		{
+			case tskNOTIFY_SET_BITS :
+				pxTCB->ulNotifiedValue |= ulValue;
+				break;
+
+			case tskNOTIFY_INCREMENT :
+				++( pxTCB->ulNotifiedValue );
+				break;
+
+			case tskNOTIFY_SET_VALUE_WITH_OVERWRITE :
+				pxTCB->ulNotifiedValue = ulValue;
+				break;
+
+			case tskNOTIFY_SET_VALUE_WITHOUT_OVERWRITE :
+				if( ucOriginalState != tskNOTIFICATION_RECEIVED )
+				{
+					pxTCB->ulNotifiedValue = ulValue;
+				}
+				else
+				{
+					/* The value could not be written to the task. */
+					cReturn = ( signed portCHAR ) pdFAIL;
+				}
+				break;
+
+			default :
+				/* The notification value is not changed. */
+				break;
+		}
+
+		if( ucOriginalState == tskWAITING_NOTIFICATION )
+		{
+			/* The task is blocked waiting for the notification, so is in the
+			delayed list but in no event list.  Its event list item is free to
+			hold it in the pending ready list if the ready lists cannot be 
+			accessed. */
+			if( ucSchedulerSuspended == ( unsigned portCHAR ) pdFALSE )
+			{
+				vListRemove( &( pxTCB->xGenericListItem ) );
+				prvAddTaskToReadyQueue( pxTCB );
+			}
+			else
+			{
+				vListInsertEnd( ( xList portOBJECT_SPACE * ) &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
+			}
+
+			if( pxTCB->ucPriority > pxCurrentTCB->ucPriority )
+			{
+				*pcTaskWoken = ( signed portCHAR ) pdTRUE;
+			}
+		}
+
+		return cReturn;
+	}
+
+#endif
 
 
 
@@ -956,31 +1969,155 @@ inline void vTaskIncrementTick( void )
 		++xTickCount;
 		if( xTickCount == ( portTickType ) 0 )
 		{
-			volatile xList *pxTemp;
-
 			/* Tick count has overflowed so we need to swap the delay lists.  If there are
-			any items in pxDelayedTaskList here then there is an error! */
-			pxTemp = pxDelayedTaskList;
-			pxDelayedTaskList = pxOverflowDelayedTaskList;
-			pxOverflowDelayedTaskList = pxTemp;
+			any items in pxDelayedTaskList here then there is an error!  The timing 
+			wheel compares exact wake times so has no lists to swap. */
+			prvTickCountOverflowed();
 		}
 
 		/* See if this tick has made a timeout expire. */
-		prvCheckDelayedTasks();
+		prvCheckDelayedTasks( portMAX_TASKS_WOKEN_PER_TICK );
 	}
 	else
 	{
-		++ucMissedTicks;
+		/* Should the scheduler remain suspended for longer than the tick
+		count can represent then every delayed task will be due anyway, so 
+		the count stops rather than wrapping back to zero. */
+		if( xMissedTicks != portMAX_DELAY )
+		{
+			++xMissedTicks;
+		}
 	}
 }
 /*-----------------------------------------------------------*/
 
+#if( portUSE_TICKLESS_IDLE == 1 )
+
+	portTickType xTaskGetExpectedIdleTime( void )
+	{
+	portTickType xReturn;
+
+		/* Called with interrupts disabled.  xNextTaskUnblockTime cannot be
+		used here as it is forced to the next tick while the scheduler is 
+		suspended, so the delayed list is inspected directly. */
+		if( ( ucTopReadyPriority > tskIDLE_PRIORITY ) ||
+			( pxReadyTasksLists[ tskIDLE_PRIORITY ].usNumberOfItems > ( unsigned portSHORT ) 1 ) ||
+			( !listLIST_IS_EMPTY( &xPendingReadyList ) ) ||
+			( xMissedTicks != ( portTickType ) 0 ) ||
+			( cDelayedTasksPending != ( signed portCHAR ) pdFALSE ) )
+		{
+			/* There is a task other than the idle task that could run, or
+			missed ticks or due tasks that need processing. */
+			xReturn = ( portTickType ) 0;
+		}
+		else
+		{
+			#if( USE_TIMING_WHEEL == 1 )
+			{
+				volatile xList portOBJECT_SPACE *pxSlot;
+				volatile xListItem portOBJECT_SPACE *pxItem;
+				unsigned portCHAR ucSlotsSearched;
+				portTickType xSlotTime;
+
+				/* The slots are not sorted, so the items within each slot are
+				inspected, starting with the slot for the next tick.  A task in
+				a later slot cannot wake before the tick of that slot, so the 
+				search can stop as soon as no later slot can hold an earlier 
+				wake time. */
+				#if( USE_TICK_EPOCH == 1 )
+				{
+					/* The start of the next tick epoch must be processed by
+					the kernel, so never sleep past the last tick before the
+					tick count wraps. */
+					xReturn = portMAX_DELAY - xTickCount;
+				}
+				#else
+				{
+					xReturn = portMAX_DELAY;
+				}
+				#endif
+
+				xSlotTime = xTickCount;
+				for( ucSlotsSearched = ( unsigned portCHAR ) 0; ucSlotsSearched < ( unsigned portCHAR ) portTIMING_WHEEL_SLOTS; ucSlotsSearched++ )
+				{
+					++xSlotTime;
+					pxSlot = &( xTimingWheel[ xSlotTime & tskTIMING_WHEEL_MASK ] );
+
+					for( pxItem = pxSlot->pxHead->pxNext; pxItem != pxSlot->pxHead; pxItem = pxItem->pxNext )
+					{
+						if( ( portTickType ) ( listGET_LIST_ITEM_VALUE( pxItem ) - xTickCount ) < xReturn )
+						{
+							xReturn = listGET_LIST_ITEM_VALUE( pxItem ) - xTickCount;
+						}
+					}
+
+					if( xReturn <= ( portTickType ) ( ( xSlotTime - xTickCount ) + ( portTickType ) 1 ) )
+					{
+						break;
+					}
+				}
+			}
+			#else
+			{
+				tskTCB portOBJECT_SPACE *pxTCB;
+
+				/* Tasks on the overflow list cannot wake before the tick count
+				wraps, and the wrap itself must be processed by the kernel, so
+				never sleep past the last tick before the wrap. */
+				xReturn = portMAX_DELAY - xTickCount;
+
+				pxTCB = ( tskTCB portOBJECT_SPACE * ) listGET_OWNER_OF_HEAD_ENTRY( pxDelayedTaskList );
+				if( pxTCB != NULL )
+				{
+					if( ( listGET_LIST_ITEM_VALUE( &( pxTCB->xGenericListItem ) ) - xTickCount ) < xReturn )
+					{
+						xReturn = listGET_LIST_ITEM_VALUE( &( pxTCB->xGenericListItem ) ) - xTickCount;
+					}
+				}
+			}
+			#endif
+
+			#if( USE_CO_ROUTINES == 1 )
+			{
+			portTickType xCoRoutineIdleTime;
+
+				/* The co-routines are run by the idle task, so the tick must
+				not be suppressed beyond the time the next co-routine is due. */
+				xCoRoutineIdleTime = xCoRoutineGetExpectedIdleTime();
+				if( xCoRoutineIdleTime < xReturn )
+				{
+					xReturn = xCoRoutineIdleTime;
+				}
+			}
+			#endif
+		}
+
+		return xReturn;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( portUSE_TICKLESS_IDLE == 1 )
+
+	void vTaskStepTick( portTickType xTicksToJump )
+	{
+		/* Called with interrupts disabled and the scheduler suspended, after
+		the tick has been suppressed for no longer than the time returned by
+		xTaskGetExpectedIdleTime().  No delayed task can become ready within
+		the ticks being jumped, so they need not be processed one at a time. */
+		xTickCount += xTicksToJump;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
 #if( ( INCLUDE_vTaskCleanUpResources == 1 ) && ( INCLUDE_vTaskSuspend == 1 ) )
 
 	void vTaskCleanUpResources( void )
 	{
 	unsigned portSHORT usQueue;
-	volatile tskTCB *pxTCB;
+	volatile tskTCB portOBJECT_SPACE *pxTCB;
 
 		usQueue = ( unsigned portSHORT ) ucTopUsedPriority + ( unsigned portSHORT ) 1;
 
@@ -992,44 +2129,74 @@ inline void vTaskIncrementTick( void )
 			while( !listLIST_IS_EMPTY( &( pxReadyTasksLists[ usQueue ] ) ) )
 			{
 				listGET_OWNER_OF_NEXT_ENTRY( pxTCB, &( pxReadyTasksLists[ usQueue ] ) )
-				vListRemove( ( xListItem * ) &( pxTCB->xGenericListItem ) );
+				vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxTCB->xGenericListItem ) );
 
-				prvDeleteTCB( ( tskTCB * ) pxTCB );
+				prvDeleteTCB( ( tskTCB portOBJECT_SPACE * ) pxTCB );
 			}
 		}while( usQueue > ( unsigned portSHORT ) tskIDLE_PRIORITY );
 
-		/* Remove any TCB's from the delayed queue. */
-		while( !listLIST_IS_EMPTY( &xDelayedTaskList1 ) )
+		#if( USE_TIMING_WHEEL == 1 )
 		{
-			listGET_OWNER_OF_NEXT_ENTRY( pxTCB, &xDelayedTaskList1 );
-			vListRemove( ( xListItem * ) &( pxTCB->xGenericListItem ) );
+			/* Remove any TCB's from the timing wheel. */
+			for( usQueue = ( unsigned portSHORT ) 0; usQueue < ( unsigned portSHORT ) portTIMING_WHEEL_SLOTS; usQueue++ )
+			{
+				while( !listLIST_IS_EMPTY( &( xTimingWheel[ usQueue ] ) ) )
+				{
+					listGET_OWNER_OF_NEXT_ENTRY( pxTCB, &( xTimingWheel[ usQueue ] ) );
+					vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxTCB->xGenericListItem ) );
+
+					prvDeleteTCB( ( tskTCB portOBJECT_SPACE * ) pxTCB );
+				}
+			}
+		}
+		#else
+		{
+			/* Remove any TCB's from the delayed queue. */
+			while( !listLIST_IS_EMPTY( &xDelayedTaskList1 ) )
+			{
+				listGET_OWNER_OF_NEXT_ENTRY( pxTCB, &xDelayedTaskList1 );
+				vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxTCB->xGenericListItem ) );
+
+				prvDeleteTCB( ( tskTCB portOBJECT_SPACE * ) pxTCB );
+			}
+
+			/* Remove any TCB's from the overflow delayed queue. */
+			while( !listLIST_IS_EMPTY( &xDelayedTaskList2 ) )
+			{
+				listGET_OWNER_OF_NEXT_ENTRY( pxTCB, &xDelayedTaskList2 );
+				vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxTCB->xGenericListItem ) );
 
-			prvDeleteTCB( ( tskTCB * ) pxTCB );
+				prvDeleteTCB( ( tskTCB portOBJECT_SPACE * ) pxTCB );
+			}
 		}
+		#endif
 
-		/* Remove any TCB's from the overflow delayed queue. */
-		while( !listLIST_IS_EMPTY( &xDelayedTaskList2 ) )
+		#if( USE_TICK_EPOCH == 1 )
 		{
-			listGET_OWNER_OF_NEXT_ENTRY( pxTCB, &xDelayedTaskList2 );
-			vListRemove( ( xListItem * ) &( pxTCB->xGenericListItem ) );
+			while( !listLIST_IS_EMPTY( &xLongDelayTaskList ) )
+			{
+				listGET_OWNER_OF_NEXT_ENTRY( pxTCB, &xLongDelayTaskList );
+				vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxTCB->xGenericListItem ) );
 
-			prvDeleteTCB( ( tskTCB * ) pxTCB );
+				prvDeleteTCB( ( tskTCB portOBJECT_SPACE * ) pxTCB );
+			}
 		}
+		#endif
 
 		while( !listLIST_IS_EMPTY( &xSuspendedTaskList ) )
 		{
 			listGET_OWNER_OF_NEXT_ENTRY( pxTCB, &xSuspendedTaskList );
-			vListRemove( ( xListItem * ) &( pxTCB->xGenericListItem ) );
+			vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxTCB->xGenericListItem ) );
 
-			prvDeleteTCB( ( tskTCB * ) pxTCB );
+			prvDeleteTCB( ( tskTCB portOBJECT_SPACE * ) pxTCB );
 		}		
 
 		while( !listLIST_IS_EMPTY( &xPendingReadyList ) )
 		{
 			listGET_OWNER_OF_NEXT_ENTRY( pxTCB, &xPendingReadyList );
-			vListRemove( ( xListItem * ) &( pxTCB->xGenericListItem ) );
+			vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxTCB->xGenericListItem ) );
 
-			prvDeleteTCB( ( tskTCB * ) pxTCB );
+			prvDeleteTCB( ( tskTCB portOBJECT_SPACE * ) pxTCB );
 		}		
 	}
 
@@ -1046,19 +2213,23 @@ inline void vTaskSwitchContext( void )
 	}
 
 	/* Find the highest priority queue that contains ready tasks. */
-	while( listLIST_IS_EMPTY( &( pxReadyTasksLists[ ucTopReadyPriority ] ) ) )
-	{
-		--ucTopReadyPriority;
-	}
+	prvSelectHighestReadyPriority();
 
 	/* listGET_OWNER_OF_NEXT_ENTRY walks through the list, so the tasks of the
 	same priority get an equal share of the processor time. */
 	listGET_OWNER_OF_NEXT_ENTRY( pxCurrentTCB, &( pxReadyTasksLists[ ucTopReadyPriority ] ) );
 	vWriteTraceToBuffer();
+
+	/* If other tasks share the priority of the selected task then the next
+	tick must be processed so they get their share of the processor time. */
+	if( pxReadyTasksLists[ ucTopReadyPriority ].usNumberOfItems > ( unsigned portSHORT ) 1 )
+	{
+		prvForceTickProcessing();
+	}
 }
 /*-----------------------------------------------------------*/
 
-void vTaskPlaceOnEventList( xList *pxEventList, portTickType xTicksToWait )
+void vTaskPlaceOnEventList( xList portOBJECT_SPACE *pxEventList, portTickType xTicksToWait )
 {
 portTickType xTimeToWake;
 
@@ -1068,7 +2239,7 @@ portTickType xTimeToWake;
 	/* Place the event list item of the TCB in the appropriate event list.
 	This is placed in the list in priority order so the highest priority task
 	is the first to be woken by the event. */
-	vListInsert( ( xList * ) pxEventList, ( xListItem * ) &( pxCurrentTCB->xEventListItem ) );
+	vListInsert( ( xList portOBJECT_SPACE * ) pxEventList, ( xListItem portOBJECT_SPACE * ) &( pxCurrentTCB->xEventListItem ) );
 
 	/* Calculate the time at which the task should be woken if the event does
 	not occur.  This may overflow but this doesn't matter. */
@@ -1077,26 +2248,16 @@ portTickType xTimeToWake;
 	/* We must remove ourselves from the ready list before adding ourselves
 	to the blocked list as the same list item is used for both lists.  We have
 	exclusive access to the ready lists as the scheduler is locked. */
-	vListRemove( ( xListItem * ) &( pxCurrentTCB->xGenericListItem ) );
+	vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxCurrentTCB->xGenericListItem ) );
+	prvResetReadyPriority( pxCurrentTCB->ucPriority );
 
-	listSET_LIST_ITEM_VALUE( &( pxCurrentTCB->xGenericListItem ), xTimeToWake );
-
-	if( xTimeToWake < xTickCount )
-	{
-		/* Wake time has overflowed.  Place this item in the overflow list. */
-		vListInsert( ( xList * ) pxOverflowDelayedTaskList, ( xListItem * ) &( pxCurrentTCB->xGenericListItem ) );
-	}
-	else
-	{
-		/* The wake time has not overflowed, so we can use the current block list. */
-		vListInsert( ( xList * ) pxDelayedTaskList, ( xListItem * ) &( pxCurrentTCB->xGenericListItem ) );
-	}
+	prvAddCurrentTaskToDelayedList( xTimeToWake );
 }
 /*-----------------------------------------------------------*/
 
-signed portCHAR cTaskRemoveFromEventList( const xList *pxEventList )
+signed portCHAR cTaskRemoveFromEventList( const xList portOBJECT_SPACE *pxEventList )
 {
-tskTCB *pxUnblockedTCB;
+tskTCB portOBJECT_SPACE *pxUnblockedTCB;
 
 	/* THIS FUNCTION MUST BE CALLED WITH INTERRUPTS DISABLED OR THE
 	SCHEDULER SUSPENDED.  It can also be called from within an ISR. */
@@ -1108,7 +2269,7 @@ tskTCB *pxUnblockedTCB;
 	If an event is for a queue that is locked then this function will never
 	get called - the lock count on the queue will get modified instead.  This
 	means we can always expect exclusive access to the event list here. */
-	pxUnblockedTCB = ( tskTCB * ) listGET_OWNER_OF_HEAD_ENTRY( pxEventList );
+	pxUnblockedTCB = ( tskTCB portOBJECT_SPACE * ) listGET_OWNER_OF_HEAD_ENTRY( pxEventList );
 	vListRemove( &( pxUnblockedTCB->xEventListItem ) );
 
 	if( ucSchedulerSuspended == ( unsigned portCHAR ) pdFALSE )
@@ -1120,7 +2281,7 @@ tskTCB *pxUnblockedTCB;
 	{
 		/* We cannot access the delayed or ready lists, so will hold this
 		task pending until the scheduler is resumed. */
-		vListInsertEnd( ( xList * ) &( xPendingReadyList ), &( pxUnblockedTCB->xEventListItem ) );
+		vListInsertEnd( ( xList portOBJECT_SPACE * ) &( xPendingReadyList ), &( pxUnblockedTCB->xEventListItem ) );
 	}
 
 	if( pxUnblockedTCB->ucPriority > pxCurrentTCB->ucPriority )
@@ -1136,6 +2297,73 @@ tskTCB *pxUnblockedTCB;
 		return ( signed portCHAR ) pdFALSE;
 	}
 }
+/*-----------------------------------------------------------*/
+
+#if( USE_EVENT_GROUPS == 1 )
+
+	void vTaskPlaceOnUnorderedEventList( xList portOBJECT_SPACE *pxEventList, portTickType xItemValue, portTickType xTicksToWait )
+	{
+		/* THIS FUNCTION MUST BE CALLED WITH INTERRUPTS DISABLED, as the
+		event list can be accessed from an ISR. */
+
+		/* The item value holds what the task is waiting for, so the item
+		cannot be placed in priority order. */
+		listSET_LIST_ITEM_VALUE( &( pxCurrentTCB->xEventListItem ), xItemValue );
+		vListInsertEnd( pxEventList, ( xListItem portOBJECT_SPACE * ) &( pxCurrentTCB->xEventListItem ) );
+
+		vListRemove( ( xListItem portOBJECT_SPACE * ) &( pxCurrentTCB->xGenericListItem ) );
+		prvResetReadyPriority( pxCurrentTCB->ucPriority );
+
+		prvAddCurrentTaskToDelayedList( xTickCount + xTicksToWait );
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( USE_EVENT_GROUPS == 1 )
+
+	signed portCHAR cTaskRemoveFromUnorderedEventList( xListItem portOBJECT_SPACE *pxEventListItem, portTickType xItemValue )
+	{
+	tskTCB portOBJECT_SPACE *pxUnblockedTCB;
+
+		/* THIS FUNCTION MUST BE CALLED WITH INTERRUPTS DISABLED.  It can 
+		also be called from within an ISR. */
+		listSET_LIST_ITEM_VALUE( pxEventListItem, xItemValue );
+		pxUnblockedTCB = ( tskTCB portOBJECT_SPACE * ) pxEventListItem->pvOwner;
+		vListRemove( pxEventListItem );
+
+		/* As cTaskRemoveFromEventList(). */
+		if( ucSchedulerSuspended == ( unsigned portCHAR ) pdFALSE )
+		{
+			vListRemove( &( pxUnblockedTCB->xGenericListItem ) );
+			prvAddTaskToReadyQueue( pxUnblockedTCB );
+		}
+		else
+		{
+			vListInsertEnd( ( xList portOBJECT_SPACE * ) &( xPendingReadyList ), &( pxUnblockedTCB->xEventListItem ) );
+		}
+
+		return ( signed portCHAR ) ( pxUnblockedTCB->ucPriority > pxCurrentTCB->ucPriority );
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+#if( USE_EVENT_GROUPS == 1 )
+
+	portTickType xTaskResetEventItemValue( void )
+	{
+	portTickType xReturn;
+
+		xReturn = listGET_LIST_ITEM_VALUE( &( pxCurrentTCB->xEventListItem ) );
+
+		/* The queue event lists are kept in priority order. */
+		listSET_LIST_ITEM_VALUE( &( pxCurrentTCB->xEventListItem ), ( portTickType ) pxCurrentTCB->ucPriority );
+
+		return xReturn;
+	}
+
+#endif
 
 
 
@@ -1155,6 +2383,44 @@ static void prvIdleTask( void *pvParameters )
 		/* See if any tasks have been deleted. */
 		prvCheckTasksWaitingTermination();
 
+		#if( USE_CO_ROUTINES == 1 )
+		{
+			/* The co-routines all run on the stack of the idle task.  Run 
+			the highest priority ready co-routine until it blocks or yields. */
+			vCoRoutineSchedule();
+		}
+		#endif
+
+		#if( portUSE_TICKLESS_IDLE == 1 )
+		{
+		portTickType xExpectedIdleTime;
+
+			/* Only suppress the tick if no task is due to run for at least
+			portMIN_TICKLESS_IDLE_TIME ticks.  This is checked again by the
+			port with interrupts disabled. */
+			portENTER_CRITICAL();
+				xExpectedIdleTime = xTaskGetExpectedIdleTime();
+			portEXIT_CRITICAL();
+
+			if( xExpectedIdleTime >= portMIN_TICKLESS_IDLE_TIME )
+			{
+				/* The scheduler is suspended while the tick is suppressed so
+				any task readied by an interrupt is held on the pending ready
+				list, and any tick that occurs is counted as a missed tick. */
+				vTaskSuspendAll();
+				{
+					vPortSuppressTicksAndSleep();
+				}
+				if( cTaskResumeAll() == pdFALSE )
+				{
+					/* The yield requested by an interrupt that readied a task
+					was ignored while the scheduler was suspended. */
+					taskYIELD();
+				}
+			}
+		}
+		#endif
+
 		if( sUsingPreemption == pdFALSE )
 		{
 			/* If we are not using preemption we keep forcing a task switch to
@@ -1178,7 +2444,7 @@ static void prvIdleTask( void *pvParameters )
 
 
 
-static void prvInitialiseTCBVariables( tskTCB *pxTCB, unsigned portSHORT usStackDepth, const signed portCHAR * const pcName, unsigned portCHAR ucPriority )
+static void prvInitialiseTCBVariables( tskTCB portOBJECT_SPACE *pxTCB, unsigned portSHORT usStackDepth, const signed portCHAR * const pcName, unsigned portCHAR ucPriority )
 {
 	pxTCB->usStackDepth = usStackDepth;
 
@@ -1204,6 +2470,19 @@ static void prvInitialiseTCBVariables( tskTCB *pxTCB, unsigned portSHORT usStack
 	}
 	pxTCB->ucPriority = ucPriority;
 
+	#if( USE_TRACE_FACILITY == 1 )
+	{
+		pxTCB->ucMaxStackBytes = ( unsigned portCHAR ) 0;
+	}
+	#endif
+
+	#if( USE_TASK_NOTIFICATIONS == 1 )
+	{
+		pxTCB->ulNotifiedValue = ( unsigned portLONG ) 0;
+		pxTCB->ucNotifyState = tskNOT_WAITING_NOTIFICATION;
+	}
+	#endif
+
 	vListInitialiseItem( &( pxTCB->xGenericListItem ) );
 	vListInitialiseItem( &( pxTCB->xEventListItem ) );
 
@@ -1224,32 +2503,62 @@ portSHORT sReturn;
 
 	for( ucPriority = ( unsigned portCHAR) 0; ucPriority < ( unsigned portCHAR ) portMAX_PRIORITIES; ucPriority++ )
 	{
-		vListInitialise( ( xList * ) &( pxReadyTasksLists[ ucPriority ] ) );
+		vListInitialise( ( xList portOBJECT_SPACE * ) &( pxReadyTasksLists[ ucPriority ] ) );
 	}
 
-	vListInitialise( ( xList * ) &xDelayedTaskList1 );
-	vListInitialise( ( xList * ) &xDelayedTaskList2 );
-	vListInitialise( ( xList * ) &xPendingReadyList );
+	#if( USE_TIMING_WHEEL == 1 )
+	{
+		for( ucPriority = ( unsigned portCHAR ) 0; ucPriority < ( unsigned portCHAR ) portTIMING_WHEEL_SLOTS; ucPriority++ )
+		{
+			vListInitialise( ( xList portOBJECT_SPACE * ) &( xTimingWheel[ ucPriority ] ) );
+		}
+	}
+	#else
+	{
+		vListInitialise( ( xList portOBJECT_SPACE * ) &xDelayedTaskList1 );
+		vListInitialise( ( xList portOBJECT_SPACE * ) &xDelayedTaskList2 );
+	}
+	#endif
+
+	vListInitialise( ( xList portOBJECT_SPACE * ) &xPendingReadyList );
+
+	#if( USE_TICK_EPOCH == 1 )
+	{
+		vListInitialise( ( xList portOBJECT_SPACE * ) &xLongDelayTaskList );
+	}
+	#endif
 
 	#if( INCLUDE_vTaskDelete == 1 )
 	{
-		vListInitialise( ( xList * ) &xTasksWaitingTermination );
+		vListInitialise( ( xList portOBJECT_SPACE * ) &xTasksWaitingTermination );
 	}
 	#endif
 
 	#if( INCLUDE_vTaskSuspend == 1 )
 	{
-		vListInitialise( ( xList * ) &xSuspendedTaskList );
+		vListInitialise( ( xList portOBJECT_SPACE * ) &xSuspendedTaskList );
 	}
 	#endif
 
-	/* Start with pxDelayedTaskList using list1 and the pxOverflowDelayedTaskList 
-	using list2. */
-	pxDelayedTaskList = &xDelayedTaskList1;
-	pxOverflowDelayedTaskList = &xDelayedTaskList2;
+	#if( USE_TIMING_WHEEL == 0 )
+	{
+		/* Start with pxDelayedTaskList using list1 and the pxOverflowDelayedTaskList 
+		using list2. */
+		pxDelayedTaskList = &xDelayedTaskList1;
+		pxOverflowDelayedTaskList = &xDelayedTaskList2;
+	}
+	#endif
 
 	/* Add the idle task at the lowest priority. */
-	sReturn = sTaskCreate( prvIdleTask, ( const portCHAR * const ) "IDLE", tskIDLE_STACK_SIZE, ( void * ) NULL, tskIDLE_PRIORITY, ( xTaskHandle * ) NULL );
+	#if( ( portNUM_STACK_SLOTS > 0 ) && ( portIDLE_TASK_STACK_SLOT != portNO_STACK_SLOT ) )
+	{
+		sReturn = sTaskCreateResident( prvIdleTask, ( const portCHAR * const ) "IDLE", ( void * ) NULL, tskIDLE_PRIORITY, ( unsigned portCHAR ) portIDLE_TASK_STACK_SLOT, ( xTaskHandle * ) NULL );
+	}
+	#else
+	{
+		sReturn = sTaskCreate( prvIdleTask, ( const portCHAR * const ) "IDLE", tskIDLE_STACK_SIZE, ( void * ) NULL, tskIDLE_PRIORITY, ( xTaskHandle * ) NULL );
+	}
+	#endif
 
 	return sReturn;
 }
@@ -1267,11 +2576,11 @@ static void prvCheckTasksWaitingTermination( void )
 
 		if( !sListIsEmpty )
 		{
-			tskTCB *pxTCB;
+			tskTCB portOBJECT_SPACE *pxTCB;
 
 			portENTER_CRITICAL();
 			{			
-				pxTCB = ( tskTCB * ) listGET_OWNER_OF_HEAD_ENTRY( ( ( xList * ) &xTasksWaitingTermination ) );
+				pxTCB = ( tskTCB portOBJECT_SPACE * ) listGET_OWNER_OF_HEAD_ENTRY( ( ( xList portOBJECT_SPACE * ) &xTasksWaitingTermination ) );
 				vListRemove( &( pxTCB->xGenericListItem ) );
 				--usCurrentNumberOfTasks;
 			}
@@ -1284,19 +2593,136 @@ static void prvCheckTasksWaitingTermination( void )
 }
 /*-----------------------------------------------------------*/
 
-static tskTCB *prvAllocateTCBAndStack( unsigned portSHORT usStackDepth )
+static void prvAddCurrentTaskToDelayedList( portTickType xTimeToWake )
+{
+	listSET_LIST_ITEM_VALUE( &( pxCurrentTCB->xGenericListItem ), xTimeToWake );
+
+	#if( USE_TIMING_WHEEL == 1 )
+	{
+		/* The slot is not sorted so the item can go at the end. */
+		vListInsertEnd( ( xList portOBJECT_SPACE * ) &( xTimingWheel[ xTimeToWake & tskTIMING_WHEEL_MASK ] ), ( xListItem portOBJECT_SPACE * ) &( pxCurrentTCB->xGenericListItem ) );
+
+		/* This function can be called with the scheduler running, so make
+		sure the tick ISR knows about the new wake time.  The times are 
+		compared relative to the tick count as either may have wrapped - the
+		differences are cast back to portTickType as the subtraction is done
+		at int precision.  If the scheduler is suspended xNextTaskUnblockTime
+		will already be the next tick. */
+		portENTER_CRITICAL();
+		{
+			if( ( portTickType ) ( xTimeToWake - xTickCount ) < ( portTickType ) ( xNextTaskUnblockTime - xTickCount ) )
+			{
+				xNextTaskUnblockTime = xTimeToWake;
+			}
+		}
+		portEXIT_CRITICAL();
+	}
+	#else
+	{
+		/* The list item will be inserted in wake time order. */
+		if( xTimeToWake < xTickCount )
+		{
+			/* Wake time has overflowed.  Place this item in the overflow list. */
+			vListInsert( ( xList portOBJECT_SPACE * ) pxOverflowDelayedTaskList, ( xListItem portOBJECT_SPACE * ) &( pxCurrentTCB->xGenericListItem ) );
+		}
+		else
+		{
+			/* The wake time has not overflowed, so we can use the current block list. */
+			vListInsert( ( xList portOBJECT_SPACE * ) pxDelayedTaskList, ( xListItem portOBJECT_SPACE * ) &( pxCurrentTCB->xGenericListItem ) );
+
+			/* This function can be called with the scheduler running, so make
+			sure the tick ISR knows about the new wake time.  If the scheduler is
+			suspended xNextTaskUnblockTime will already be the next tick.  It 
+			can be numerically lower than xTickCount once limited by 
+			prvLimitNextTaskUnblockTime(), so the times are compared relative
+			to the tick count. */
+			portENTER_CRITICAL();
+			{
+				if( ( portTickType ) ( xTimeToWake - xTickCount ) < ( portTickType ) ( xNextTaskUnblockTime - xTickCount ) )
+				{
+					xNextTaskUnblockTime = xTimeToWake;
+				}
+			}
+			portEXIT_CRITICAL();
+		}
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+static void prvAdvanceTickCount( portTickType xTicksToAdvance )
 {
-tskTCB *pxNewTCB;
+	#if( USE_TIMING_WHEEL == 1 )
+	{
+		/* Finish any ticks left pending by the wake limit first, so the range
+		of ticks checked below can never exceed what a portTickType can hold. */
+		if( cDelayedTasksPending != ( signed portCHAR ) pdFALSE )
+		{
+			prvCheckDelayedTasks( 0 );
+		}
+
+		/* The ticks being processed are then pending, and are all checked 
+		together. */
+		xFirstPendingTick = xTickCount + ( portTickType ) 1;
+		cDelayedTasksPending = pdTRUE;
+
+		xTickCount += xTicksToAdvance;
+		if( xTickCount < xTicksToAdvance )
+		{
+			/* The tick count wrapped within the ticks being processed. */
+			prvTickCountOverflowed();
+		}
+
+		prvCheckDelayedTasks( 0 );
+	}
+	#else
+	{
+	portTickType xNewTickCount;
+
+		xNewTickCount = xTickCount + xTicksToAdvance;
+
+		if( xNewTickCount < xTickCount )
+		{
+			/* The tick count wraps within the ticks being processed.  Every
+			task on the current delayed list is due before the wrap, so wake 
+			them all before swapping the delay lists as vTaskIncrementTick() 
+			does. */
+			xTickCount = portMAX_DELAY;
+			prvCheckDelayedTasks( 0 );
+
+			xTickCount = ( portTickType ) 0;
+			prvTickCountOverflowed();
+		}
+
+		/* The delayed list is sorted, so the tasks due by the new tick count
+		are all at its head. */
+		xTickCount = xNewTickCount;
+		prvCheckDelayedTasks( 0 );
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+static tskTCB portOBJECT_SPACE *prvAllocateTCBAndStack( unsigned portSHORT usStackDepth )
+{
+tskTCB portOBJECT_SPACE *pxNewTCB;
 
 	/* Allocate space for the TCB.  Where the memory comes from depends on
 	the implementation of the port malloc function. */
-	pxNewTCB = ( tskTCB * ) pvPortMalloc( sizeof( tskTCB ) );
+	pxNewTCB = ( tskTCB portOBJECT_SPACE * ) pvPortMalloc( sizeof( tskTCB ) );
 
 	if( pxNewTCB != NULL )
 	{
 		/* Allocate space for the stack used by the task being created.  
 		The base of the stack memory stored in the TCB so the task can 
-		be deleted later if required. */
+		be deleted later if required.  A depth of zero is used for tasks
+		that have a resident stack slot, which need no stack from the heap. */
+		if( usStackDepth == ( unsigned portSHORT ) 0 )
+		{
+			pxNewTCB->pxStack = NULL;
+			return pxNewTCB;
+		}
+
 		pxNewTCB->pxStack = ( portSTACK_TYPE * ) pvPortMalloc( usStackDepth * sizeof( portSTACK_TYPE ) );
 
 		if( pxNewTCB->pxStack == NULL )
@@ -1318,10 +2744,10 @@ tskTCB *pxNewTCB;
 
 #if( USE_TRACE_FACILITY == 1 )
 
-	static void prvListTaskWithinSingleList( signed portCHAR *pcWriteBuffer, xList *pxList, signed portCHAR cStatus )
+	static void prvListTaskWithinSingleList( signed portCHAR *pcWriteBuffer, xList portOBJECT_SPACE *pxList, signed portCHAR cStatus )
 	{
-	volatile tskTCB *pxNextTCB, *pxFirstTCB;
-	static signed portCHAR pcStatusString[ 50 ];
+	volatile tskTCB portOBJECT_SPACE *pxNextTCB, *pxFirstTCB;
+	static signed portCHAR portKERNEL_DATA pcStatusString[ 50 ];
 	unsigned portSHORT usStackRemaining;
 
 		/* Write the details of all the TCB's in pxList into the buffer. */
@@ -1329,7 +2755,7 @@ tskTCB *pxNewTCB;
 		do
 		{
 			listGET_OWNER_OF_NEXT_ENTRY( pxNextTCB, pxList );
-			usStackRemaining = usPortCheckFreeStackSpace( ( unsigned portCHAR * ) pxNextTCB->pxStack, tskSTACK_FILL_BYTE );
+			usStackRemaining = prvTaskFreeStackSpace( ( tskTCB portOBJECT_SPACE * ) pxNextTCB );
 			sprintf( pcStatusString, "%s\t\t%c\t%u\t%u\t%d\r\n", pxNextTCB->pcTaskName, cStatus, pxNextTCB->ucPriority, usStackRemaining, pxNextTCB->ucTCBNumber );
 			strcat( pcWriteBuffer, pcStatusString );
 
@@ -1339,9 +2765,40 @@ tskTCB *pxNewTCB;
 #endif
 /*-----------------------------------------------------------*/
 
+#if( USE_TRACE_FACILITY == 1 )
+
+	static unsigned portSHORT prvTaskFreeStackSpace( const tskTCB portOBJECT_SPACE *pxTCB )
+	{
+	unsigned portSHORT usFreeSpace;
+
+		if( pxTCB->pxStack == NULL )
+		{
+			/* The stack is in a resident slot, which is not filled. */
+			usFreeSpace = ( unsigned portSHORT ) 0;
+		}
+		else
+		{
+			/* The port scans from the end of the stack that is used last. */
+			#if( portSTACK_GROWTH < 0 )
+			{
+				usFreeSpace = usPortCheckFreeStackSpace( ( unsigned portCHAR * ) pxTCB->pxStack, tskSTACK_FILL_BYTE );
+			}
+			#else
+			{
+				usFreeSpace = usPortCheckFreeStackSpace( ( unsigned portCHAR * ) ( pxTCB->pxStack + pxTCB->usStackDepth - ( unsigned portSHORT ) 1 ), tskSTACK_FILL_BYTE );
+			}
+			#endif
+		}
+
+		return usFreeSpace;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
 #if( ( INCLUDE_vTaskDelete == 1 ) || ( INCLUDE_vTaskCleanUpResources == 1 ) )
 
-	static void prvDeleteTCB( tskTCB *pxTCB )
+	static void prvDeleteTCB( tskTCB portOBJECT_SPACE *pxTCB )
 	{
 		/* Free up the memory allocated by the scheduler for the task.  It is up to
 		the task to free any memory allocated at the application level. */
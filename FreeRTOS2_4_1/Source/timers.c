@@ -0,0 +1,501 @@
+/*
+	FreeRTOS V2.4.1 - Copyright (C) 2003, 2004 Richard Barry.
+
+	This file is part of the FreeRTOS distribution.
+
+	FreeRTOS is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	FreeRTOS is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with FreeRTOS; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+	A special exception to the GPL can be applied should you wish to distribute
+	a combined work that includes FreeRTOS, without being obliged to provide
+	the source code for any proprietary components.  See the licensing section 
+	of http://www.FreeRTOS.org for full details of how and when the exception
+	can be applied.
+
+	***************************************************************************
+	See http://www.FreeRTOS.org for documentation, latest information, license 
+	and contact details.  Please ensure to read the configuration and relevant 
+	port sections of the online documentation.
+	***************************************************************************
+*/
+
+/*
+ * Software timers.  Each timer is a small structure rather than a task, and a
+ * single timer task calls the callback function of each timer as it expires.
+ *
+ * The active timers are held in a list sorted by expiry time, so the timer
+ * task need only look at the head of the list to know how long it can block.
+ * Like the delayed task lists in tasks.c a second list holds the timers that
+ * expire after the tick count next wraps, and the two are swapped when it
+ * does.  The timer API functions do not access the lists - they send commands
+ * to the timer task on a queue, so the lists are only ever accessed by the 
+ * timer task and the commands can be sent from an ISR.
+ */
+
+#include <stdlib.h>
+#include "projdefs.h"
+#include "portable.h"
+#include "task.h"
+#include "queue.h"
+#include "list.h"
+#include "timers.h"
+
+#if USE_TIMERS == 1
+
+/* The definition of a software timer. */
+typedef struct tmrTimerControl
+{
+	xListItem xTimerListItem;						/*< Used to reference the timer from an active timer list.  The item value is the expiry time. */
+	portTickType xTimerPeriodInTicks;				/*< How quickly and often the timer expires. */
+	unsigned portCHAR ucAutoReload;					/*< Set to pdTRUE if the timer restarts itself each time it expires. */
+	void *pvTimerID;								/*< An ID to identify the timer to the callback function. */
+	tmrTIMER_CALLBACK pxCallbackFunction;			/*< The function called when the timer expires. */
+} xTIMER;
+
+/* The definition of a command sent to the timer task. */
+typedef struct tmrTimerMessage
+{
+	signed portCHAR cMessageID;						/*< One of the tmrCOMMAND_ values defined in timers.h. */
+	portTickType xMessageValue;						/*< The time the command was sent for tmrCOMMAND_START, or the new period for tmrCOMMAND_CHANGE_PERIOD. */
+	xTIMER portOBJECT_SPACE *pxTimer;				/*< The timer the command applies to. */
+} xTIMER_MESSAGE;
+
+/* Lists of active timers sorted by expiry time.  Timers that expire after the
+tick count next wraps are referenced from pxOverflowTimerList. */
+static xList portKERNEL_DATA xActiveTimerList1;
+static xList portKERNEL_DATA xActiveTimerList2;
+static xList portOBJECT_SPACE * portKERNEL_DATA pxCurrentTimerList;
+static xList portOBJECT_SPACE * portKERNEL_DATA pxOverflowTimerList;
+
+/* The queue used to send commands to the timer task.  Created along with the 
+first timer, or when the scheduler is started if no timer has been created. */
+static xQueueHandle portKERNEL_DATA xTimerQueue = NULL;
+
+/* The tick count when the timer task last looked at the time, used to detect
+the tick count wrapping. */
+static portTickType portKERNEL_DATA xLastTime = ( portTickType ) 0;
+
+/* The task that processes the commands and calls the callback functions. */
+static void prvTimerTask( void *pvParameters );
+
+/*
+ * Creates the timer lists and the command queue if they have not been 
+ * created already.  Returns pdFAIL if the queue could not be created.
+ */
+static signed portCHAR prvCheckForValidListAndQueue( void );
+
+/*
+ * Returns the tick count.  Should the tick count have wrapped since it was 
+ * last sampled, every timer still in the current list has expired - these 
+ * are processed before the lists are swapped.
+ */
+static portTickType prvSampleTimeNow( void );
+
+/*
+ * Calls the callback function of every timer that has expired by xTimeNow, 
+ * restarting those that auto-reload.
+ */
+static void prvProcessExpiredTimers( portTickType xTimeNow );
+
+/*
+ * Inserts a timer that was started at xStartTime into the active lists.  The
+ * callback function is called for any expiry that has already passed by 
+ * xTimeNow, as can happen if the timer task could not run for a while.
+ */
+static void prvStartTimer( xTIMER portOBJECT_SPACE *pxTimer, portTickType xStartTime, portTickType xTimeNow );
+
+/*
+ * Inserts a timer into the list matching its expiry time.  Returns pdTRUE, 
+ * without inserting the timer, if the expiry time has already passed.
+ */
+static signed portCHAR prvInsertTimerInActiveList( xTIMER portOBJECT_SPACE *pxTimer, portTickType xNextExpiryTime, portTickType xTimeNow, portTickType xCommandTime );
+
+/*
+ * Returns the number of ticks the timer task can block for before the timer
+ * at the head of the current list expires.
+ */
+static portTickType prvGetTicksToWait( void );
+
+/*
+ * Carries out a command received on the timer queue.
+ */
+static void prvProcessCommand( const xTIMER_MESSAGE *pxMessage );
+
+/*-----------------------------------------------------------
+ * PUBLIC TIMER API documented in timers.h
+ *----------------------------------------------------------*/
+
+portSHORT sTimerCreateTimerTask( void )
+{
+portSHORT sReturn = pdFAIL;
+
+	if( prvCheckForValidListAndQueue() == pdPASS )
+	{
+		sReturn = sTaskCreate( prvTimerTask, ( const signed portCHAR * const ) "TIMER", portTIMER_TASK_STACK_SIZE, ( void * ) NULL, portTIMER_TASK_PRIORITY, ( xTaskHandle * ) NULL );
+	}
+
+	return sReturn;
+}
+/*-----------------------------------------------------------*/
+
+xTimerHandle xTimerCreate( portTickType xTimerPeriod, unsigned portCHAR ucAutoReload, void *pvTimerID, tmrTIMER_CALLBACK pxCallbackFunction )
+{
+xTIMER portOBJECT_SPACE *pxNewTimer = NULL;
+
+	/* A timer with a period of 0 would expire continuously. */
+	if( ( xTimerPeriod > ( portTickType ) 0 ) && ( prvCheckForValidListAndQueue() == pdPASS ) )
+	{
+		pxNewTimer = ( xTIMER portOBJECT_SPACE * ) pvPortMalloc( sizeof( xTIMER ) );
+		if( pxNewTimer != NULL )
+		{
+			pxNewTimer->xTimerPeriodInTicks = xTimerPeriod;
+			pxNewTimer->ucAutoReload = ucAutoReload;
+			pxNewTimer->pvTimerID = pvTimerID;
+			pxNewTimer->pxCallbackFunction = pxCallbackFunction;
+			vListInitialiseItem( &( pxNewTimer->xTimerListItem ) );
+			listSET_LIST_ITEM_OWNER( &( pxNewTimer->xTimerListItem ), pxNewTimer );
+		}
+	}
+
+	return ( xTimerHandle ) pxNewTimer;
+}
+/*-----------------------------------------------------------*/
+
+void *pvTimerGetTimerID( xTimerHandle xTimer )
+{
+	return ( ( xTIMER portOBJECT_SPACE * ) xTimer )->pvTimerID;
+}
+/*-----------------------------------------------------------*/
+
+signed portCHAR cTimerIsTimerActive( xTimerHandle xTimer )
+{
+signed portCHAR cReturn;
+
+	/* The timer task can move the timer between lists at any time. */
+	taskENTER_CRITICAL();
+	{
+		if( ( ( xTIMER portOBJECT_SPACE * ) xTimer )->xTimerListItem.pvContainer != NULL )
+		{
+			cReturn = pdTRUE;
+		}
+		else
+		{
+			cReturn = pdFALSE;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return cReturn;
+}
+/*-----------------------------------------------------------*/
+
+signed portCHAR cTimerGenericCommand( xTimerHandle xTimer, signed portCHAR cCommandID, portTickType xCommandValue, portTickType xBlockTime )
+{
+xTIMER_MESSAGE xMessage;
+
+	xMessage.cMessageID = cCommandID;
+	xMessage.xMessageValue = xCommandValue;
+	xMessage.pxTimer = ( xTIMER portOBJECT_SPACE * ) xTimer;
+
+	return cQueueSend( xTimerQueue, &xMessage, xBlockTime );
+}
+/*-----------------------------------------------------------*/
+
+signed portCHAR cTimerGenericCommandFromISR( xTimerHandle xTimer, signed portCHAR cCommandID, portTickType xCommandValue, signed portCHAR cTaskPreviouslyWoken )
+{
+xTIMER_MESSAGE xMessage;
+
+	xMessage.cMessageID = cCommandID;
+	xMessage.xMessageValue = xCommandValue;
+	xMessage.pxTimer = ( xTIMER portOBJECT_SPACE * ) xTimer;
+
+	return cQueueSendFromISR( xTimerQueue, &xMessage, cTaskPreviouslyWoken );
+}
+/*-----------------------------------------------------------*/
+
+/*-----------------------------------------------------------
+ * The timer task.
+ *----------------------------------------------------------*/
+
+static void prvTimerTask( void *pvParameters )
+{
+xTIMER_MESSAGE xMessage;
+
+	/* Just to prevent compiler warnings. */
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		/* Call the callback of each timer that has expired. */
+		prvProcessExpiredTimers( prvSampleTimeNow() );
+
+		/* Block until either the next timer expires or a command arrives. 
+		Time taken between working out the block time and blocking can make
+		a callback late by that much, but never early as the expired timers 
+		are found by comparing against the tick count. */
+		if( cQueueReceive( xTimerQueue, &xMessage, prvGetTicksToWait() ) == pdTRUE )
+		{
+			/* Carry out the command and any others that are waiting. */
+			do
+			{
+				prvProcessCommand( &xMessage );
+			} while( cQueueReceive( xTimerQueue, &xMessage, ( portTickType ) 0 ) == pdTRUE );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvProcessCommand( const xTIMER_MESSAGE *pxMessage )
+{
+xTIMER portOBJECT_SPACE *pxTimer;
+portTickType xTimeNow;
+
+	pxTimer = pxMessage->pxTimer;
+
+	/* Sample the time after receiving the command, so the lists are swapped
+	before the timer is inserted should the tick count have wrapped. */
+	xTimeNow = prvSampleTimeNow();
+
+	/* Every command first stops the timer if it is running. */
+	if( pxTimer->xTimerListItem.pvContainer != NULL )
+	{
+		vListRemove( &( pxTimer->xTimerListItem ) );
+	}
+
+	switch( pxMessage->cMessageID )
+	{
+		case tmrCOMMAND_START :
+			/* The timer runs from the time the command was sent, not the 
+			time it was received. */
+			prvStartTimer( pxTimer, pxMessage->xMessageValue, xTimeNow );
+			break;
+
+		case tmrCOMMAND_CHANGE_PERIOD :
+			if( pxMessage->xMessageValue > ( portTickType ) 0 )
+			{
+				pxTimer->xTimerPeriodInTicks = pxMessage->xMessageValue;
+			}
+			prvStartTimer( pxTimer, xTimeNow, xTimeNow );
+			break;
+
+		case tmrCOMMAND_DELETE :
+			vPortFree( pxTimer );
+			break;
+
+		default :
+			/* tmrCOMMAND_STOP - the timer has already been stopped. */
+			break;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvProcessExpiredTimers( portTickType xTimeNow )
+{
+xTIMER portOBJECT_SPACE *pxTimer;
+portTickType xExpiryTime;
+
+	/* The list is sorted, so the expired timers are all at its head. */
+	while( ( pxTimer = ( xTIMER portOBJECT_SPACE * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList ) ) != NULL )
+	{
+		xExpiryTime = listGET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ) );
+		if( xTimeNow < xExpiryTime )
+		{
+			break;
+		}
+
+		vListRemove( &( pxTimer->xTimerListItem ) );
+		pxTimer->pxCallbackFunction( ( xTimerHandle ) pxTimer );
+
+		/* An auto-reload timer restarts from the time it expired rather than
+		the time now, so its period does not drift. */
+		if( pxTimer->ucAutoReload != ( unsigned portCHAR ) pdFALSE )
+		{
+			prvStartTimer( pxTimer, xExpiryTime, xTimeNow );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvStartTimer( xTIMER portOBJECT_SPACE *pxTimer, portTickType xStartTime, portTickType xTimeNow )
+{
+	while( prvInsertTimerInActiveList( pxTimer, xStartTime + pxTimer->xTimerPeriodInTicks, xTimeNow, xStartTime ) == pdTRUE )
+	{
+		/* The timer has already expired. */
+		pxTimer->pxCallbackFunction( ( xTimerHandle ) pxTimer );
+
+		if( pxTimer->ucAutoReload == ( unsigned portCHAR ) pdFALSE )
+		{
+			break;
+		}
+
+		xStartTime += pxTimer->xTimerPeriodInTicks;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static signed portCHAR prvInsertTimerInActiveList( xTIMER portOBJECT_SPACE *pxTimer, portTickType xNextExpiryTime, portTickType xTimeNow, portTickType xCommandTime )
+{
+signed portCHAR cExpired = pdFALSE;
+
+	listSET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ), xNextExpiryTime );
+
+	/* The differences are cast back to portTickType as the subtraction is 
+	done at int precision. */
+	if( xNextExpiryTime <= xTimeNow )
+	{
+		if( ( portTickType ) ( xTimeNow - xCommandTime ) >= pxTimer->xTimerPeriodInTicks )
+		{
+			/* A whole period has passed since the timer was started. */
+			cExpired = pdTRUE;
+		}
+		else
+		{
+			/* The expiry time has wrapped past the tick count. */
+			vListInsert( pxOverflowTimerList, &( pxTimer->xTimerListItem ) );
+		}
+	}
+	else
+	{
+		if( ( xTimeNow < xCommandTime ) && ( xNextExpiryTime >= xCommandTime ) )
+		{
+			/* The tick count has wrapped since the timer was started but the
+			expiry time has not, so the expiry time has passed. */
+			cExpired = pdTRUE;
+		}
+		else
+		{
+			vListInsert( pxCurrentTimerList, &( pxTimer->xTimerListItem ) );
+		}
+	}
+
+	return cExpired;
+}
+/*-----------------------------------------------------------*/
+
+static portTickType prvSampleTimeNow( void )
+{
+portTickType xTimeNow;
+xTIMER portOBJECT_SPACE *pxTimer;
+xList portOBJECT_SPACE *pxTemp;
+
+	xTimeNow = xTaskGetTickCount();
+
+	if( xTimeNow < xLastTime )
+	{
+		/* The tick count has wrapped, so every timer left in the current list
+		has expired.  An auto-reload timer whose next expiry is also before 
+		the wrap goes back into the current list to be processed again. */
+		while( ( pxTimer = ( xTIMER portOBJECT_SPACE * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList ) ) != NULL )
+		{
+			xLastTime = listGET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ) );
+			vListRemove( &( pxTimer->xTimerListItem ) );
+			pxTimer->pxCallbackFunction( ( xTimerHandle ) pxTimer );
+
+			if( pxTimer->ucAutoReload != ( unsigned portCHAR ) pdFALSE )
+			{
+				listSET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ), xLastTime + pxTimer->xTimerPeriodInTicks );
+				if( listGET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ) ) > xLastTime )
+				{
+					vListInsert( pxCurrentTimerList, &( pxTimer->xTimerListItem ) );
+				}
+				else
+				{
+					vListInsert( pxOverflowTimerList, &( pxTimer->xTimerListItem ) );
+				}
+			}
+		}
+
+		pxTemp = pxCurrentTimerList;
+		pxCurrentTimerList = pxOverflowTimerList;
+		pxOverflowTimerList = pxTemp;
+	}
+
+	xLastTime = xTimeNow;
+
+	return xTimeNow;
+}
+/*-----------------------------------------------------------*/
+
+static portTickType prvGetTicksToWait( void )
+{
+portTickType xTimeNow, xTicksToWait;
+xTIMER portOBJECT_SPACE *pxTimer;
+
+	xTimeNow = xTaskGetTickCount();
+
+	if( xTimeNow < xLastTime )
+	{
+		/* The tick count has wrapped since the lists were last looked at. */
+		xTicksToWait = ( portTickType ) 0;
+	}
+	else
+	{
+		pxTimer = ( xTIMER portOBJECT_SPACE * ) listGET_OWNER_OF_HEAD_ENTRY( pxCurrentTimerList );
+		if( pxTimer != NULL )
+		{
+			if( listGET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ) ) > xTimeNow )
+			{
+				xTicksToWait = listGET_LIST_ITEM_VALUE( &( pxTimer->xTimerListItem ) ) - xTimeNow;
+			}
+			else
+			{
+				xTicksToWait = ( portTickType ) 0;
+			}
+		}
+		else
+		{
+			/* Nothing expires before the tick count wraps, which must be seen
+			so the lists can be swapped.  Wake at the last tick before the 
+			wrap, and then again one tick later. */
+			xTicksToWait = portMAX_DELAY - xTimeNow;
+			if( xTicksToWait == ( portTickType ) 0 )
+			{
+				xTicksToWait = ( portTickType ) 1;
+			}
+		}
+	}
+
+	return xTicksToWait;
+}
+/*-----------------------------------------------------------*/
+
+static signed portCHAR prvCheckForValidListAndQueue( void )
+{
+signed portCHAR cReturn = pdPASS;
+
+	/* Timers can be created by more than one task. */
+	taskENTER_CRITICAL();
+	{
+		if( xTimerQueue == NULL )
+		{
+			vListInitialise( ( xList portOBJECT_SPACE * ) &xActiveTimerList1 );
+			vListInitialise( ( xList portOBJECT_SPACE * ) &xActiveTimerList2 );
+			pxCurrentTimerList = ( xList portOBJECT_SPACE * ) &xActiveTimerList1;
+			pxOverflowTimerList = ( xList portOBJECT_SPACE * ) &xActiveTimerList2;
+			xLastTime = xTaskGetTickCount();
+
+			xTimerQueue = xQueueCreate( ( unsigned portCHAR ) portTIMER_QUEUE_LENGTH, ( unsigned portCHAR ) sizeof( xTIMER_MESSAGE ) );
+			if( xTimerQueue == NULL )
+			{
+				cReturn = pdFAIL;
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return cReturn;
+}
+
+#endif /* USE_TIMERS */
+